@@ -0,0 +1,47 @@
+using System;
+
+namespace PsyFile.Tests
+{
+	public static class BeerZ77Tests
+	{
+		// One literal and a four byte match for every cell, the most a match can cost.
+		public static void CompressesCellsThatDifferInOneByte()
+		{
+			PsyPattern pattern = new PsyPattern(0, 255, 1);
+			for (int line = 0; line < pattern.Lines; line++)
+			{
+				pattern.SetEvent(line, 0, (byte)line, 1, 2, 3, 4);
+			}
+			RoundTrip(pattern.Data);
+		}
+		
+		public static void CompressesRandomFourSymbolData()
+		{
+			Random random = new Random(1);
+			foreach (int count in new int[] { 5, 64, 1000, 4096, 65536, 300000 })
+			{
+				byte[] data = new byte[count];
+				for (int i = 0; i < data.Length; i++) data[i] = (byte)random.Next(4);
+				RoundTrip(data);
+			}
+		}
+		
+		public static void CompressesIntoTheMiddleOfABuffer()
+		{
+			byte[] data = new byte[1000];
+			for (int i = 0; i < data.Length; i++) data[i] = (byte)(i % 5 == 0 ? i : i % 5);
+			byte[] dest = new byte[BeerZ77.MaxCompressedSize(data.Length) + 20];
+			int length = BeerZ77.Compress(data, 0, data.Length, dest, 10);
+			byte[] packed = new byte[length];
+			Buffer.BlockCopy(dest, 10, packed, 0, length);
+			Check.AreEqual(data, BeerZ77.Decompress(packed), "round trip");
+		}
+		
+		static void RoundTrip(byte[] data)
+		{
+			byte[] packed = BeerZ77.Compress(data);
+			Check.IsTrue(packed.Length <= BeerZ77.MaxCompressedSize(data.Length), "compressed size is within the bound");
+			Check.AreEqual(data, BeerZ77.Decompress(packed), "round trip");
+		}
+	}
+}
@@ -0,0 +1,34 @@
+using System;
+
+namespace PsyFile.Tests
+{
+	class CheckException : Exception
+	{
+		public CheckException (string message)
+			: base(message)
+		{
+		}
+	}
+	
+	static class Check
+	{
+		public static void IsTrue(bool condition, string message)
+		{
+			if (!condition) throw new CheckException(message);
+		}
+		
+		public static void AreEqual<T>(T expected, T actual, string message)
+		{
+			if (!Equals(expected, actual)) throw new CheckException(string.Format ("{0}: expected {1}, got {2}", message, expected, actual));
+		}
+		
+		public static void AreEqual(byte[] expected, byte[] actual, string message)
+		{
+			AreEqual(expected.Length, actual.Length, message + ", length");
+			for (int i = 0; i < expected.Length; i++)
+			{
+				if (expected[i] != actual[i]) throw new CheckException(string.Format ("{0}: bytes differ at {1}", message, i));
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+using System;
+using System.Reflection;
+
+namespace PsyFile.Tests
+{
+	// Runs every public static method without parameters of the *Tests classes.
+	// Returns the number of tests that failed.
+	class MainClass
+	{
+		public static int Main (string[] args)
+		{
+			int failed = 0;
+			int run = 0;
+			foreach (Type type in typeof(MainClass).Assembly.GetTypes())
+			{
+				if (!type.Name.EndsWith("Tests")) continue;
+				
+				foreach (MethodInfo method in type.GetMethods(BindingFlags.Public | BindingFlags.Static))
+				{
+					if (method.GetParameters().Length != 0) continue;
+					
+					run++;
+					try
+					{
+						method.Invoke(null, null);
+					}
+					catch (TargetInvocationException ex)
+					{
+						failed++;
+						Console.WriteLine("FAIL {0}.{1}: {2}", type.Name, method.Name, ex.InnerException);
+					}
+				}
+			}
+			Console.WriteLine("{0} tests, {1} failed.", run, failed);
+			return failed;
+		}
+	}
+}
@@ -0,0 +1,185 @@
+using System;
+using System.IO;
+
+namespace PsyFile.Tests
+{
+	public static class PsyBinaryWriterTests
+	{
+		// Patterns that compress worse than they are large are written whole.
+		public static void SavesPatternsThatDoNotCompress()
+		{
+			PsyFile song = NewSong(1);
+			PsyPattern pattern = song.CreatePattern(0, 255);
+			for (int line = 0; line < pattern.Lines; line++)
+			{
+				pattern.SetEvent(line, 0, (byte)line, 1, 2, 3, 4);
+			}
+			
+			foreach (PsyPatternCodec codec in new PsyPatternCodec[] { PsyPatternCodec.BeerZ77, PsyPatternCodec.Columns })
+			{
+				PsyFile copy = SaveAndLoad(song, codec);
+				Check.AreEqual(pattern.Data, copy.Patterns[0].Data, codec + " pattern");
+			}
+		}
+		
+		// End fills in the size in the header, nothing is written out before it.
+		public static void ChunkBufferPatchesTheSize()
+		{
+			PsyChunkBuffer chunk = new PsyChunkBuffer();
+			chunk.Begin("OLD!", 1).Write(new byte[7]);
+			BinaryWriter writer = chunk.Begin("TEST", 3);
+			writer.Write(1);
+			int sizeOffset = chunk.Length;
+			writer.Write(0);
+			writer.Write((short)2);
+			chunk.Patch(sizeOffset, 2);
+			chunk.End();
+			
+			MemoryStream stream = new MemoryStream();
+			chunk.WriteTo(stream);
+			Check.AreEqual(new byte[] { (byte)'T', (byte)'E', (byte)'S', (byte)'T', 3, 0, 0, 0, 10, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 2, 0 },
+				stream.ToArray(), "chunk");
+		}
+		
+		public static void TrimPastTheReservedBytesThrows()
+		{
+			PsyChunkBuffer chunk = new PsyChunkBuffer();
+			int offset;
+			chunk.Reserve(16, out offset);
+			chunk.Trim(offset + 8);
+			try
+			{
+				chunk.Trim(offset + 9);
+			}
+			catch (InvalidOperationException)
+			{
+				return;
+			}
+			throw new CheckException("Trim grew the buffer.");
+		}
+		
+		// Chunks are encoded on the thread pool but written in index order, so
+		// the file does not depend on which finishes first or on the cache.
+		public static void ParallelSavesAreTheSame()
+		{
+			byte[] first = Save(RandomSong(60, 3));
+			PsyFile song = RandomSong(60, 3);
+			Check.AreEqual(first, Save(song), "second song");
+			Check.AreEqual(first, Save(song), "saved from the cache");
+			
+			PsyFile copy = SaveAndLoad(song, PsyPatternCodec.BeerZ77);
+			int index = 0;
+			foreach (PsyChunk chunk in copy.Chunks)
+			{
+				if (chunk.Id != "PATD") continue;
+				Check.AreEqual(index, BitConverter.ToInt32(first, (int)chunk.Offset), "pattern order");
+				index++;
+			}
+			Check.AreEqual(60, index, "patterns");
+		}
+		
+		// Song::Load reads every line with the song's track count.
+		public static void NarrowPatternsAreSavedWithTheSongsTracks()
+		{
+			PsyFile song = NewSong(4);
+			PsyPattern pattern = song.CreatePattern(0, 16);
+			pattern.Resize(16, 2);
+			pattern.SetEvent(3, 1, 60, 1, 0, 0, 0);
+			pattern.SetEvent(15, 0, 62, 2, 0, 0, 0);
+			song.PlayOrder = new int[] { 0 };
+			
+			foreach (PsyPatternCodec codec in new PsyPatternCodec[] { PsyPatternCodec.BeerZ77, PsyPatternCodec.Columns })
+			{
+				PsyFile copy = SaveAndLoad(song, codec);
+				PsyPattern wide = copy.Patterns[0];
+				Check.AreEqual(4, wide.Tracks, codec + " tracks");
+				Check.AreEqual(2, wide.UsedCells, codec + " used cells");
+				
+				PsyFile cut = SaveAndLoad(copy, codec);
+				cut.Patterns[0].Resize(16, 2);
+				Check.AreEqual(pattern.Data, cut.Patterns[0].Data, codec + " cells");
+			}
+			
+			pattern.Compact();
+			Check.AreEqual(4, SaveAndLoad(song, PsyPatternCodec.Columns).Patterns[0].Tracks, "sparse pattern tracks");
+		}
+		
+		// The encoded chunk is kept between saves until the pattern changes, and a
+		// write through Data is a change.
+		public static void EditThroughDataIsSaved()
+		{
+			PsyFile song = NewSong(2);
+			PsyPattern pattern = song.CreatePattern(0, 16);
+			pattern.SetEvent(0, 0, 48, 1, 0, 0, 0);
+			song.PlayOrder = new int[] { 0 };
+			SaveAndLoad(song, PsyPatternCodec.BeerZ77);
+			int revision = pattern.Revision;
+			SaveAndLoad(song, PsyPatternCodec.BeerZ77);
+			Check.AreEqual(revision, pattern.Revision, "saving leaves the revision");
+			
+			pattern.Data[PsyFile.EventSize] = 50;
+			PsyFile copy = SaveAndLoad(song, PsyPatternCodec.BeerZ77);
+			Check.AreEqual((byte)50, copy.Patterns[0].Data[PsyFile.EventSize], "edited note");
+			Check.AreEqual(pattern.Data, copy.Patterns[0].Data, "saved cells");
+		}
+		
+		internal static PsyFile NewSong(int tracks)
+		{
+			PsyFile song = new PsyFile();
+			song.Tracks = tracks;
+			song.TrackMuted = new bool[tracks];
+			song.TrackArmed = new bool[tracks];
+			song.TrackNames = new string[tracks];
+			for (int t = 0; t < tracks; t++) song.TrackNames[t] = "";
+			song.ShareTrackNames = true;
+			song.Title = song.Artist = song.Comments = song.SequenceName = "";
+			return song;
+		}
+		
+		// Patterns of different lengths with random cells, all in the sequence.
+		internal static PsyFile RandomSong(int patterns, int seed)
+		{
+			PsyFile song = NewSong(4);
+			Random random = new Random(seed);
+			int[] order = new int[patterns];
+			for (int i = 0; i < patterns; i++)
+			{
+				PsyPattern pattern = song.CreatePattern(i, 16 + random.Next(100));
+				for (int n = random.Next(64); n > 0; n--)
+				{
+					pattern.SetEvent(random.Next(pattern.Lines), random.Next(4), (byte)random.Next(120), (byte)random.Next(8), 0, 0, 0);
+				}
+				order[i] = i;
+			}
+			song.PlayOrder = order;
+			return song;
+		}
+		
+		static byte[] Save(PsyFile song)
+		{
+			MemoryStream stream = new MemoryStream();
+			new PsyBinaryWriter(stream, song).WritePsyBinary();
+			return stream.ToArray();
+		}
+		
+		internal static PsyFile SaveAndLoad(PsyFile song, PsyPatternCodec codec)
+		{
+			return SaveAndLoad(song, codec, new PsyReadOptions());
+		}
+		
+		internal static PsyFile SaveAndLoad(PsyFile song, PsyPatternCodec codec, PsyReadOptions options)
+		{
+			MemoryStream stream = new MemoryStream();
+			PsyBinaryWriter writer = new PsyBinaryWriter(stream, song);
+			writer.PatternCodec = codec;
+			writer.WritePsyBinary();
+			stream.Position = 0;
+			
+			PsyFile copy = new PsyFile();
+			using (PsyReader reader = new PsyReader(stream, copy, options))
+			{
+			}
+			return copy;
+		}
+	}
+}
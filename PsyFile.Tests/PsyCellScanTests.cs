@@ -0,0 +1,36 @@
+using System;
+
+namespace PsyFile.Tests
+{
+	public static class PsyCellScanTests
+	{
+		// Used cells in and across the 40 byte blocks, and in the tail after the
+		// last whole block, from offsets that are not block aligned.
+		public static void BlockScanMatchesTheCellByCellScan()
+		{
+			Random random = new Random(6);
+			for (int n = 0; n < 200; n++)
+			{
+				int cells = random.Next(40);
+				byte[] data = new byte[(cells + 3) * PsyFile.EventSize];
+				PsyPattern.FillBlank(data, 0, data.Length);
+				for (int used = random.Next(4); used > 0; used--)
+				{
+					data[random.Next(data.Length)] = (byte)random.Next(4);
+				}
+				
+				int offset = random.Next(3) * PsyFile.EventSize;
+				int count = cells * PsyFile.EventSize;
+				int expected = PsyCellScan.CountUsedByCell(data, offset, count);
+				Check.AreEqual(expected, PsyCellScan.CountUsed(data, offset, count), "used cells");
+				
+				int first = -1;
+				for (int cell = 0; cell < cells && first < 0; cell++)
+				{
+					if (PsyCellScan.CountUsedByCell(data, offset + cell * PsyFile.EventSize, PsyFile.EventSize) > 0) first = cell;
+				}
+				Check.AreEqual(first, PsyCellScan.FirstUsed(data, offset, count), "first used cell");
+			}
+		}
+	}
+}
@@ -0,0 +1,46 @@
+using System;
+using System.IO;
+
+namespace PsyFile.Tests
+{
+	public static class PsyExporterTests
+	{
+		public static void JsonHasTheCellsThatAreNotBlank()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			song.BeatsPerMinute = 125;
+			song.CreatePattern(0, 16).SetEvent(3, 1, 60, 2, 0, 0, 0);
+			song.PlayOrder = new int[] { 0 };
+			
+			string json = Export(song);
+			Check.IsTrue(json.Contains("\"bpm\":125"), "bpm");
+			Check.IsTrue(json.Contains("\"sequence\":[0]"), "sequence");
+			Check.IsTrue(json.Contains("{\"line\":3,\"track\":1,\"note\":60,\"inst\":2,\"mach\":0,\"cmd\":0,\"parameter\":0}"), "event");
+			Check.AreEqual(1, json.Split(new string[] { "\"line\":" }, StringSplitOptions.None).Length - 1, "events");
+		}
+		
+		// Neither stops the export or writes something that is not JSON.
+		public static void JsonCopesWithNaNAndPatternsWithoutLines()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			song.BeatsPerMinute = float.NaN;
+			PsyPattern pattern = song.CreatePattern(0, 0);
+			pattern.Data = new byte[2 * PsyFile.EventSize];
+			song.PlayOrder = new int[] { 0 };
+			
+			string json = Export(song);
+			Check.IsTrue(json.Contains("\"bpm\":null"), "bpm");
+			Check.IsTrue(!json.Contains("NaN"), "no NaN");
+			Check.IsTrue(json.Contains("\"events\":[]"), "no events");
+		}
+		
+		static string Export(PsyFile song)
+		{
+			PsyExportOptions options = new PsyExportOptions();
+			options.IncludePatterns = true;
+			StringWriter output = new StringWriter();
+			new PsyExporter(options).Export(song, "song.psy", output);
+			return output.ToString();
+		}
+	}
+}
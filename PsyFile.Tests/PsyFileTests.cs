@@ -0,0 +1,88 @@
+using System;
+
+namespace PsyFile.Tests
+{
+	public static class PsyFileTests
+	{
+		public static void AddTrackSkipsPatternsThatEndBeforeIt()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(4);
+			PsyPattern full = song.CreatePattern(0, 16);
+			full.SetEvent(0, 3, 48, 0, 0, 0, 0);
+			PsyPattern narrow = new PsyPattern(1, 16, 2);
+			song.Patterns[1] = narrow;
+			PsyPattern empty = song.CreatePattern(2, 0);
+			
+			song.AddTrack(3);
+			
+			Check.AreEqual(5, song.Tracks, "song tracks");
+			Check.AreEqual(5, song.TrackMuted.Length, "muted tracks");
+			Check.AreEqual(5, full.Tracks, "full pattern tracks");
+			Check.AreEqual(2, narrow.Tracks, "narrow pattern tracks");
+			Check.AreEqual(0, empty.Tracks, "empty pattern tracks");
+			Check.AreEqual((byte)48, full.Data[4 * PsyFile.EventSize], "note moved to track 4");
+			Check.AreEqual(PsyPattern.EmptyNote, full.Data[3 * PsyFile.EventSize], "track 3 is blank");
+			
+			song.AddTrack(2);
+			Check.AreEqual(3, narrow.Tracks, "narrow pattern grows when the track is inside it");
+		}
+		
+		public static void GetUsedInstrumentsLooksAtTheSequence()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			song.CreatePattern(0, 16).SetEvent(0, 0, 48, 1, 0, 0, 0);
+			song.CreatePattern(1, 16).SetEvent(0, 1, 48, 2, 0, 0, 0);
+			PsyPattern sparse = song.CreatePattern(2, 16);
+			sparse.SetEvent(7, 1, 48, 3, 0, 0, 0);
+			sparse.Compact();
+			song.PlayOrder = new int[] { 2, 0, 2, 0 };
+			
+			bool[] used = song.GetUsedInstruments();
+			Check.IsTrue(used[1] && used[3], "instruments of the patterns played");
+			Check.IsTrue(!used[2], "instrument of a pattern not in the sequence");
+			Check.IsTrue(sparse.Sparse != null, "sparse pattern stays sparse");
+		}
+		
+		public static void GetBlankPatternUnusedFallsBackLikeSong()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(1);
+			for (int i = 0; i < PsyFile.MaxPatterns; i++)
+			{
+				song.CreatePattern(i, 4).SetEvent(0, 0, 48, 0, 0, 0, 0);
+			}
+			song.PlayOrder = new int[] { 0, 1, 254, 255 };
+			
+			// Every pattern has data, the search runs past the end.
+			Check.AreEqual(2, song.GetBlankPatternUnused(0), "first pattern not in the sequence");
+			
+			song.Patterns[100].SetEvent(0, 0, PsyPattern.EmptyNote, PsyPattern.EmptyInst, PsyPattern.EmptyMach, 0, 0);
+			Check.AreEqual(100, song.GetBlankPatternUnused(0), "blank pattern not in the sequence");
+			
+			song.Patterns[7] = null;
+			Check.AreEqual(7, song.GetBlankPatternUnused(0), "pattern that does not exist");
+		}
+		
+		public static void SnapshotKeepsItsOwnSequenceIndex()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			song.CreatePattern(0, 16);
+			song.CreatePattern(1, 16);
+			song.CreatePattern(2, 16);
+			song.PlayOrder = new int[] { 0, 1 };
+			
+			PsyFile snapshot = song.Snapshot();
+			song.SetSequenceEntry(1, 2);
+			
+			Check.AreEqual(1, snapshot.PlayOrder[1], "snapshot sequence");
+			Check.IsTrue(snapshot.IsInSequence(1), "pattern 1 is still in the snapshot's sequence");
+			Check.IsTrue(!snapshot.IsInSequence(2), "pattern 2 is not in the snapshot's sequence");
+			Check.AreEqual(1, snapshot.GetHighestPatternIndexInSequence(), "snapshot highest pattern");
+			Check.IsTrue(snapshot.IsPatternUsed(1), "pattern 1 is used in the snapshot");
+			Check.IsTrue(!snapshot.IsPatternUsed(2), "pattern 2 is not used in the snapshot");
+			
+			Check.IsTrue(!song.IsInSequence(1), "pattern 1 left the song's sequence");
+			Check.IsTrue(song.IsInSequence(2), "pattern 2 is in the song's sequence");
+			Check.AreEqual(2, song.GetHighestPatternIndexInSequence(), "song highest pattern");
+		}
+	}
+}
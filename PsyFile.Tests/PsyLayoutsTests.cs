@@ -0,0 +1,44 @@
+using System;
+
+namespace PsyFile.Tests
+{
+	public static class PsyLayoutsTests
+	{
+		public static void Int32sAreLittleEndian()
+		{
+			int[] values = { 0, 1, -1, 0x12345678 };
+			byte[] data = PsyLayouts.EncodeInt32s(values);
+			Check.AreEqual(new byte[] { 0, 0, 0, 0, 1, 0, 0, 0, 255, 255, 255, 255, 0x78, 0x56, 0x34, 0x12 }, data, "encoded");
+			int[] decoded = PsyLayouts.DecodeInt32s(data);
+			Check.AreEqual(values.Length, decoded.Length, "decoded count");
+			for (int i = 0; i < values.Length; i++)
+			{
+				Check.AreEqual(values[i], decoded[i], "decoded " + i);
+			}
+		}
+		
+		// The block holds the SNGI fields in the order Song::Load reads them.
+		public static void SongPropertiesRoundTrip()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(12);
+			song.BeatsPerMinute = 125.5f;
+			song.LinesPerBeat = 6;
+			song.CurrentOctave = 3;
+			song.InstSelected = 9;
+			
+			byte[] data = PsyLayouts.SongProperties.Encode(song);
+			Check.AreEqual(11 * sizeof(int), data.Length, "size");
+			Check.AreEqual(12, BitConverter.ToInt32(data, 0), "tracks first");
+			Check.AreEqual(125 | (50 << 16), BitConverter.ToInt32(data, 4), "bpm and hundredths");
+			
+			PsyFile copy = new PsyFile();
+			PsyLayouts.SongProperties.Decode(data, copy);
+			Check.AreEqual(12, copy.Tracks, "tracks");
+			Check.AreEqual(125.5f, copy.BeatsPerMinute, "bpm");
+			Check.AreEqual(6, copy.LinesPerBeat, "lines per beat");
+			Check.AreEqual(3, copy.CurrentOctave, "octave");
+			Check.AreEqual(9, copy.InstSelected, "instrument");
+			Check.AreEqual(1, copy.SequenceWidth, "sequence width");
+		}
+	}
+}
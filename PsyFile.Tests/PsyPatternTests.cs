@@ -0,0 +1,177 @@
+using System;
+
+namespace PsyFile.Tests
+{
+	public static class PsyPatternTests
+	{
+		public static void ColumnPatternsMatchRowPatterns()
+		{
+			PsyFile rows = PsyBinaryWriterTests.NewSong(4);
+			PsyFile columns = PsyBinaryWriterTests.NewSong(4);
+			Random random = new Random(1);
+			for (int i = 0; i < 3; i++)
+			{
+				PsyPattern row = rows.CreatePattern(i, 16 + i);
+				PsyPattern column = columns.CreatePattern(i, 16 + i);
+				column.UseColumns();
+				for (int n = 0; n < 20; n++)
+				{
+					int line = random.Next(row.Lines), track = random.Next(4);
+					byte note = (byte)random.Next(120), inst = (byte)random.Next(4);
+					row.SetEvent(line, track, note, inst, 0, 0, 0);
+					column.SetEvent(line, track, note, inst, 0, 0, 0);
+				}
+				Check.AreEqual(row.UsedCells, column.UsedCells, "used cells");
+			}
+			rows.AddTrack(1);
+			columns.AddTrack(1);
+			rows.AddTrack(5);
+			columns.AddTrack(5);
+			
+			for (int i = 0; i < 3; i++)
+			{
+				Check.IsTrue(columns.Patterns[i].Columns != null, "still in columns after AddTrack");
+				Check.AreEqual(rows.Patterns[i].Tracks, columns.Patterns[i].Tracks, "tracks");
+				Check.AreEqual(rows.Patterns[i].Data, columns.Patterns[i].Data, "cells");
+			}
+		}
+		
+		public static void ColumnPatternsKeepEditsCountedAndSnapshotsApart()
+		{
+			PsyPattern pattern = new PsyPattern(0, 8, 2);
+			pattern.UseColumns();
+			Check.AreEqual(0, pattern.UsedCells, "blank pattern");
+			pattern.SetEvent(3, 1, 60, 2, 0, 0, 0);
+			PsyPattern snapshot = pattern.Snapshot();
+			pattern.SetEvent(3, 1, PsyPattern.EmptyNote, PsyPattern.EmptyInst, PsyPattern.EmptyMach, 0, 0);
+			
+			Check.AreEqual(0, pattern.UsedCells, "after clearing the cell");
+			Check.IsTrue(pattern.IsEmpty(), "pattern is empty");
+			Check.AreEqual(1, snapshot.UsedCells, "snapshot keeps the cell");
+			Check.AreEqual((byte)60, snapshot.Columns.GetField(3, 1, PsyPatternColumns.NoteField), "snapshot note");
+		}
+		
+		public static void ColumnPatternsSaveLikeRowPatterns()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			PsyPattern pattern = song.CreatePattern(0, 16);
+			pattern.SetEvent(2, 1, 48, 1, 0, 0, 0);
+			song.PlayOrder = new int[] { 0 };
+			PsyFile copy = PsyBinaryWriterTests.SaveAndLoad(song, PsyPatternCodec.BeerZ77);
+			
+			pattern.UseColumns();
+			PsyFile columns = PsyBinaryWriterTests.SaveAndLoad(song, PsyPatternCodec.BeerZ77);
+			Check.IsTrue(pattern.Columns != null, "saving leaves the columns");
+			Check.AreEqual(copy.Patterns[0].Data, columns.Patterns[0].Data, "saved cells");
+			Check.IsTrue(song.GetUsedInstruments()[1], "instrument 1 is used");
+		}
+		
+		// Stretching spreads the lines out with blank lines between them, shrinking
+		// keeps every step-th line, as Song::AllocNewPattern does.
+		public static void StretchKeepsLinesWhereTheyFallInTime()
+		{
+			PsyPattern pattern = new PsyPattern(0, 4, 2);
+			for (int line = 0; line < 4; line++)
+			{
+				pattern.SetEvent(line, 1, (byte)(48 + line), 1, 0, 0, 0);
+			}
+			byte[] original = (byte[])pattern.Data.Clone();
+			
+			pattern.Stretch(8);
+			Check.AreEqual(8, pattern.Lines, "stretched lines");
+			Check.AreEqual(2, pattern.Tracks, "stretched tracks");
+			for (int line = 0; line < 8; line++)
+			{
+				byte note = pattern.Data[(line * 2 + 1) * PsyFile.EventSize];
+				Check.AreEqual(line % 2 == 0 ? (byte)(48 + line / 2) : PsyPattern.EmptyNote, note, "note on line " + line);
+			}
+			
+			pattern.Stretch(4);
+			Check.AreEqual(original, pattern.Data, "shrunk back");
+			
+			pattern.Stretch(2);
+			Check.AreEqual((byte)48, pattern.Data[PsyFile.EventSize], "first kept line");
+			Check.AreEqual((byte)50, pattern.Data[3 * PsyFile.EventSize], "second kept line");
+		}
+		
+		public static void SparsePatternsOnlyKeepMostlyBlankPatterns()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(4);
+			PsyPattern dense = song.CreatePattern(0, 16);
+			for (int line = 0; line < 16; line++)
+			{
+				for (int track = 0; track < 4; track++)
+				{
+					if (track != 2) dense.SetEvent(line, track, (byte)(line + track), 1, 0, 0, 0);
+				}
+			}
+			PsyPattern blank = song.CreatePattern(1, 16);
+			blank.SetEvent(0, 0, 48, 1, 0, 0, 0);
+			blank.SetEvent(15, 3, 50, 2, 0, 12, 34);
+			song.PlayOrder = new int[] { 0, 1 };
+			
+			PsyReadOptions options = new PsyReadOptions();
+			options.SparsePatterns = true;
+			PsyFile copy = PsyBinaryWriterTests.SaveAndLoad(song, PsyPatternCodec.BeerZ77, options);
+			Check.IsTrue(copy.Patterns[0].Sparse == null, "dense pattern stays dense");
+			Check.IsTrue(copy.Patterns[1].Sparse != null, "mostly blank pattern is compacted");
+			Check.AreEqual(2, copy.Patterns[1].UsedCells, "used cells");
+			
+			foreach (PsyPatternCodec codec in new PsyPatternCodec[] { PsyPatternCodec.BeerZ77, PsyPatternCodec.Columns })
+			{
+				PsyFile again = PsyBinaryWriterTests.SaveAndLoad(copy, codec);
+				Check.IsTrue(copy.Patterns[1].Sparse != null, codec + " saving leaves the pattern sparse");
+				Check.AreEqual(dense.Data, again.Patterns[0].Data, codec + " dense cells");
+				Check.AreEqual(blank.Data, again.Patterns[1].Data, codec + " sparse cells");
+			}
+		}
+		
+		public static void SharedCellsAreCopiedOnWrite()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			for (int i = 0; i < 3; i++)
+			{
+				song.CreatePattern(i, 16).SetEvent(2, 0, 60, 1, 0, 0, 0);
+			}
+			song.CreatePattern(3, 16);
+			song.PlayOrder = new int[] { 0, 1, 2, 3 };
+			Check.AreEqual(2, song.SharePatterns(), "patterns sharing");
+			
+			song.Patterns[1].Data[2 * 2 * PsyFile.EventSize] = 61;
+			Check.AreEqual(0, song.SharePatterns(), "the others still share");
+			Check.AreEqual((byte)60, song.Patterns[0].Data[2 * 2 * PsyFile.EventSize], "the others keep their note");
+			Check.AreEqual((byte)60, song.Patterns[2].Data[2 * 2 * PsyFile.EventSize], "the last copy keeps its note");
+			
+			PsyFile copy = PsyBinaryWriterTests.SaveAndLoad(song, PsyPatternCodec.BeerZ77);
+			Check.AreEqual((byte)61, copy.Patterns[1].Data[2 * 2 * PsyFile.EventSize], "edit saved");
+			Check.AreEqual(song.Patterns[2].Data, copy.Patterns[2].Data, "shared cells saved");
+		}
+		
+		// Column patterns that get shared are kept row by row, so an edit to one
+		// shows up in its cells and in nothing else.
+		public static void ColumnPatternsCanBeShared()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			for (int i = 0; i < 3; i++)
+			{
+				song.CreatePattern(i, 16).SetEvent(4, 1, 60, 1, 0, 0, 0);
+			}
+			song.Patterns[2].SetEvent(5, 0, 62, 1, 0, 0, 0);
+			song.PlayOrder = new int[] { 0, 1, 2 };
+			
+			PsyReadOptions options = new PsyReadOptions();
+			options.ColumnPatterns = true;
+			options.SharePatterns = true;
+			PsyFile copy = PsyBinaryWriterTests.SaveAndLoad(song, PsyPatternCodec.BeerZ77, options);
+			Check.IsTrue(copy.Patterns[0].Columns == null && copy.Patterns[1].Columns == null, "shared patterns are row by row");
+			Check.IsTrue(copy.Patterns[2].Columns != null, "the pattern without a copy keeps its columns");
+			Check.AreEqual(0, copy.SharePatterns(), "nothing left to share");
+			
+			copy.Patterns[1].SetEvent(4, 1, PsyPattern.EmptyNote, PsyPattern.EmptyInst, PsyPattern.EmptyMach, 0, 0);
+			Check.AreEqual(0, copy.Patterns[1].UsedCells, "used cells after the edit");
+			Check.AreEqual(copy.Patterns[1].UsedCells, PsyCellScan.CountUsed(copy.Patterns[1].Data, 0, copy.Patterns[1].Data.Length), "used cells match the cells");
+			Check.AreEqual(1, copy.Patterns[0].UsedCells, "the copy keeps its cell");
+			Check.AreEqual(song.Patterns[0].Data, copy.Patterns[0].Data, "the copy's cells");
+		}
+	}
+}
@@ -0,0 +1,57 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+
+namespace PsyFile.Tests
+{
+	public static class PsyProgressTests
+	{
+		// Steps closer together than Interval are dropped, the last one never is.
+		public static void ReportsTheLastStep()
+		{
+			List<int> done = new List<int>();
+			int total = 0;
+			PsyProgress progress = new PsyProgress((d, t) => { done.Add(d); total = t; });
+			progress.Interval = TimeSpan.FromHours(1);
+			
+			PsyReadOptions options = new PsyReadOptions();
+			options.Progress = progress;
+			PsyFile copy = PsyBinaryWriterTests.SaveAndLoad(PsyBinaryWriterTests.RandomSong(20, 4), PsyPatternCodec.BeerZ77, options);
+			Check.AreEqual(copy.Chunks.Count, total, "total");
+			Check.IsTrue(done.Count <= 2, "steps dropped");
+			Check.AreEqual(total, done[done.Count - 1], "last step");
+		}
+		
+		public static void CancelledLoadsAndSavesThrow()
+		{
+			CancellationTokenSource cancel = new CancellationTokenSource();
+			cancel.Cancel();
+			PsyFile song = PsyBinaryWriterTests.RandomSong(20, 5);
+			
+			MemoryStream stream = new MemoryStream();
+			new PsyBinaryWriter(stream, song).WritePsyBinary();
+			stream.Position = 0;
+			PsyReadOptions options = new PsyReadOptions();
+			options.Progress = new PsyProgress(null, cancel.Token);
+			CheckCancelled(() => new PsyReader(stream, new PsyFile(), options).Dispose(), "load");
+			
+			PsyBinaryWriter writer = new PsyBinaryWriter(new MemoryStream(), song);
+			writer.Progress = new PsyProgress(null, cancel.Token);
+			CheckCancelled(writer.WritePsyBinary, "save");
+		}
+		
+		static void CheckCancelled(Action action, string message)
+		{
+			try
+			{
+				action();
+			}
+			catch (OperationCanceledException)
+			{
+				return;
+			}
+			throw new CheckException(message + " was not cancelled.");
+		}
+	}
+}
@@ -0,0 +1,224 @@
+using System;
+using System.IO;
+using System.Threading;
+
+namespace PsyFile.Tests
+{
+	public static class PsyReaderTests
+	{
+		// EINS versions carry the XMSampler version in the high 16 bits.
+		public static void FindsEinsAfterJunk()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(1);
+			song.CreatePattern(0, 16).SetEvent(0, 0, 48, 0, 0, 0, 0);
+			PsyChunk eins = new PsyChunk();
+			eins.Id = "EINS";
+			eins.Version = 0x00010001;
+			eins.Data = new byte[] { 0, 0, 0, 0 };
+			song.Chunks.Add(eins);
+			
+			MemoryStream stream = new MemoryStream();
+			new PsyBinaryWriter(stream, song).WritePsyBinary();
+			byte[] file = stream.ToArray();
+			int at = IndexOf(file, PsyFile.StringEncoding.GetBytes("EINS"));
+			Check.IsTrue(at > 0, "EINS is written");
+			
+			byte[] junk = new byte[1000];
+			new Random(1).NextBytes(junk);
+			byte[] damaged = new byte[file.Length + junk.Length];
+			Buffer.BlockCopy(file, 0, damaged, 0, at);
+			Buffer.BlockCopy(junk, 0, damaged, at, junk.Length);
+			Buffer.BlockCopy(file, at, damaged, at + junk.Length, file.Length - at);
+			
+			foreach (bool seekable in new bool[] { true, false })
+			{
+				Stream input = new MemoryStream(damaged);
+				if (!seekable) input = new ForwardOnlyStream(input);
+				PsyFile copy = new PsyFile();
+				using (PsyReader reader = new PsyReader(input, copy))
+				{
+				}
+				PsyChunk found = copy.Chunks.Find(chunk => chunk.Id == "EINS");
+				Check.IsTrue(found != null, (seekable ? "seekable" : "pipe") + " read finds EINS");
+				Check.AreEqual(eins.Version, found.Version, "EINS version");
+				Check.AreEqual(eins.Data, found.Data, "EINS data");
+			}
+		}
+		
+		// Disposing unmaps the file, so the wave prefetch has to be stopped first.
+		public static void DisposeStopsTheWavePrefetch()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(1);
+			song.CreatePattern(0, 16).SetEvent(0, 0, 48, 0, 255, 0, 0);
+			song.PlayOrder = new int[] { 0 };
+			PsyInstrument instrument = new PsyInstrument();
+			instrument.Name = "";
+			for (int i = 0; i < 16; i++)
+			{
+				PsyWave wave = new PsyWave();
+				wave.Index = i;
+				wave.Name = "";
+				wave.Length = 1 << 19;
+				wave.PackedLeft = new byte[1 << 20];
+				instrument.Waves.Add(wave);
+			}
+			song.Instruments[0] = instrument;
+			
+			string path = Path.GetTempFileName();
+			try
+			{
+				using (FileStream stream = File.Create(path))
+				{
+					new PsyBinaryWriter(stream, song).WritePsyBinary();
+				}
+				
+				PsyReadOptions options = new PsyReadOptions();
+				options.LazyWaves = true;
+				options.PrefetchWaves = true;
+				for (int n = 0; n < 20; n++)
+				{
+					PsyFile copy = new PsyFile();
+					using (PsyReader reader = new PsyReader(path, copy, options))
+					{
+					}
+					int loaded = copy.Instruments[0].Waves.FindAll(wave => wave.IsLoaded).Count;
+					Thread.Sleep(10);
+					Check.AreEqual(loaded, copy.Instruments[0].Waves.FindAll(wave => wave.IsLoaded).Count, "waves loaded after Dispose");
+				}
+			}
+			finally
+			{
+				File.Delete(path);
+			}
+		}
+		
+		// With LazyPatterns the z77 data is kept until Data is used, code that only
+		// reads the cells decompresses a copy.
+		public static void LazyPatternsStayPackedUntilDataIsUsed()
+		{
+			PsyFile song = PsyBinaryWriterTests.NewSong(2);
+			PsyPattern pattern = song.CreatePattern(0, 16);
+			pattern.SetEvent(5, 1, 60, 1, 0, 0, 0);
+			song.PlayOrder = new int[] { 0 };
+			
+			PsyReadOptions options = new PsyReadOptions();
+			options.LazyPatterns = true;
+			PsyFile copy = PsyBinaryWriterTests.SaveAndLoad(song, PsyPatternCodec.BeerZ77, options);
+			PsyPattern lazy = copy.Patterns[0];
+			Check.IsTrue(!lazy.IsUnpacked, "packed after loading");
+			Check.AreEqual(1, lazy.UsedCells, "used cells");
+			Check.IsTrue(!lazy.IsEmpty(), "not empty");
+			Check.IsTrue(copy.GetUsedInstruments()[1], "instrument 1 is used");
+			Check.AreEqual(16, lazy.Tracks * lazy.Lines / 2, "tracks");
+			Check.IsTrue(!lazy.IsUnpacked, "still packed after reading the cells");
+			
+			Check.AreEqual(pattern.Data, lazy.Data, "cells");
+			Check.IsTrue(lazy.IsUnpacked, "unpacked by Data");
+		}
+		
+		// The chunk table points at each chunk's data, and the patterns decoded from
+		// it on the thread pool are the ones read in order from a pipe.
+		public static void DecodesPatternsFromTheChunkTable()
+		{
+			PsyFile song = PsyBinaryWriterTests.RandomSong(40, 1);
+			MemoryStream stream = new MemoryStream();
+			new PsyBinaryWriter(stream, song).WritePsyBinary();
+			byte[] file = stream.ToArray();
+			
+			foreach (bool seekable in new bool[] { true, false })
+			{
+				Stream input = new MemoryStream(file);
+				if (!seekable) input = new ForwardOnlyStream(input);
+				PsyFile copy = new PsyFile();
+				using (PsyReader reader = new PsyReader(input, copy))
+				{
+				}
+				string how = seekable ? "seekable" : "pipe";
+				Check.AreEqual(40, copy.Chunks.FindAll(chunk => chunk.Id == "PATD").Count, how + " PATD chunks");
+				foreach (PsyChunk chunk in copy.Chunks)
+				{
+					Check.AreEqual(chunk.Id, PsyFile.StringEncoding.GetString(file, (int)chunk.Offset - 12, 4), how + " chunk offset");
+				}
+				for (int i = 0; i < 40; i++)
+				{
+					Check.AreEqual(song.Patterns[i].Data, copy.Patterns[i].Data, how + " pattern " + i);
+				}
+			}
+		}
+		
+		// Chunks left out are still listed, but nothing is decoded from them.
+		public static void DecodesOnlyTheChunksAskedFor()
+		{
+			PsyFile song = PsyBinaryWriterTests.RandomSong(3, 2);
+			song.Title = "title";
+			song.BeatsPerMinute = 140;
+			
+			PsyReadOptions options = new PsyReadOptions();
+			options.Chunks = PsyChunkKinds.SongProperties | PsyChunkKinds.Sequence;
+			PsyFile copy = PsyBinaryWriterTests.SaveAndLoad(song, PsyPatternCodec.BeerZ77, options);
+			Check.AreEqual(3, copy.Chunks.FindAll(chunk => chunk.Id == "PATD").Count, "PATD chunks listed");
+			Check.IsTrue(Array.TrueForAll(copy.Patterns, pattern => pattern == null), "no patterns");
+			Check.IsTrue(copy.Title != "title", "INFO left out");
+			Check.AreEqual(140f, copy.BeatsPerMinute, "bpm");
+			Check.AreEqual(3, copy.PlayOrder.Length, "sequence");
+			Check.IsTrue(copy.IsInSequence(2), "sequence index");
+		}
+		
+		static int IndexOf(byte[] data, byte[] value)
+		{
+			for (int i = 0; i + value.Length <= data.Length; i++)
+			{
+				int n = 0;
+				while (n < value.Length && data[i + n] == value[n]) n++;
+				if (n == value.Length) return i;
+			}
+			return -1;
+		}
+		
+		// Like a pipe: reads only.
+		class ForwardOnlyStream : Stream
+		{
+			readonly Stream inner;
+			
+			public ForwardOnlyStream (Stream inner)
+			{
+				this.inner = inner;
+			}
+			
+			public override bool CanRead { get { return true; } }
+			public override bool CanSeek { get { return false; } }
+			public override bool CanWrite { get { return false; } }
+			public override long Length { get { throw new NotSupportedException(); } }
+			
+			public override long Position
+			{
+				get { throw new NotSupportedException(); }
+				set { throw new NotSupportedException(); }
+			}
+			
+			public override int Read(byte[] buffer, int offset, int count)
+			{
+				return inner.Read(buffer, offset, count);
+			}
+			
+			public override void Flush()
+			{
+			}
+			
+			public override long Seek(long offset, SeekOrigin origin)
+			{
+				throw new NotSupportedException();
+			}
+			
+			public override void SetLength(long value)
+			{
+				throw new NotSupportedException();
+			}
+			
+			public override void Write(byte[] buffer, int offset, int count)
+			{
+				throw new NotSupportedException();
+			}
+		}
+	}
+}
@@ -0,0 +1,200 @@
+using System;
+using System.IO;
+using System.Runtime.InteropServices;
+
+namespace PsyFile
+{
+	// The LZ77 variant psycle uses for PATD data (BEERZ77Comp2/BEERZ77Decomp2).
+	//
+	// uint32 unpacked size, followed by blocks until that size is reached:
+	//   0, count - 1, byte[count]     literal bytes
+	//   length, uint16 distance       copy length bytes from distance bytes back
+	public static class BeerZ77
+	{
+		const int MinMatch = 4;
+		const int MaxMatch = 255;
+		const int MaxDistance = 65535;
+		const int MaxLiterals = 256;
+		const int HashBits = 14;
+		const int MaxChain = 64;
+		
+		// Hash tables kept per thread between calls.
+		[ThreadStatic] static int[] headTable;
+		[ThreadStatic] static int[] chainTable;
+		
+		public static byte[] Compress(byte[] source)
+		{
+			if (source == null) throw new ArgumentNullException("source");
+			
+			return Compress(source, 0, source.Length);
+		}
+		
+		public static byte[] Compress(byte[] source, int offset, int count)
+		{
+			byte[] dest = new byte[MaxCompressedSize(count)];
+			int length = Compress(source, offset, count, dest, 0);
+			byte[] result = new byte[length];
+			Buffer.BlockCopy(dest, 0, result, 0, length);
+			return result;
+		}
+		
+		// Room Compress needs for count bytes at worst. A match costs 3 bytes and a
+		// literal block 2 more than its bytes, so the most a literal run and the match
+		// after it can add is one byte for every five they cover (one literal and a
+		// four byte match). The literals at the end, with no match after them, add 2
+		// bytes per block.
+		public static int MaxCompressedSize(int count)
+		{
+			return 4 + count + count / (MinMatch + 1) + 2 * (count / MaxLiterals + 1);
+		}
+		
+		// Greedy matching over hash chains of 4 byte prefixes. Compresses straight into
+		// dest, which needs MaxCompressedSize(count) bytes from destOffset, and returns
+		// the compressed length.
+		public static int Compress(byte[] source, int offset, int count, byte[] dest, int destOffset)
+		{
+			if (source == null) throw new ArgumentNullException("source");
+			if (dest == null) throw new ArgumentNullException("dest");
+			if (offset < 0 || count < 0 || offset + count > source.Length) throw new ArgumentOutOfRangeException("count");
+			if (destOffset < 0 || destOffset + MaxCompressedSize(count) > dest.Length) throw new ArgumentOutOfRangeException("destOffset");
+			
+			int d = destOffset;
+			dest[d++] = (byte)count;
+			dest[d++] = (byte)(count >> 8);
+			dest[d++] = (byte)(count >> 16);
+			dest[d++] = (byte)(count >> 24);
+			
+			// Thread statics are slow to reach, the loop works on locals.
+			if (headTable == null) headTable = new int[1 << HashBits];
+			if (chainTable == null || chainTable.Length < count) chainTable = new int[count];
+			int[] head = headTable;
+			int[] chain = chainTable;
+			for (int h = 0; h < head.Length; h++) head[h] = -1;
+			
+			int end = offset + count;
+			int literals = offset;
+			int s = offset;
+			while (s < end)
+			{
+				int bestLength = 0;
+				int bestDistance = 0;
+				if (s + MinMatch <= end)
+				{
+					int h = Hash(source, s);
+					int candidate = head[h];
+					int maxLength = Math.Min(MaxMatch, end - s);
+					for (int tries = 0; candidate >= 0 && s - candidate <= MaxDistance && tries < MaxChain; tries++)
+					{
+						int length = 0;
+						while (length < maxLength && source[candidate + length] == source[s + length]) length++;
+						if (length > bestLength)
+						{
+							bestLength = length;
+							bestDistance = s - candidate;
+							if (length == maxLength) break;
+						}
+						candidate = chain[candidate - offset];
+					}
+				}
+				
+				if (bestLength >= MinMatch)
+				{
+					d = WriteLiterals(source, literals, s, dest, d);
+					dest[d++] = (byte)bestLength;
+					dest[d++] = (byte)bestDistance;
+					dest[d++] = (byte)(bestDistance >> 8);
+					for (int i = 0; i < bestLength; i++, s++) Insert(source, s, end, offset, head, chain);
+					literals = s;
+				}
+				else
+				{
+					Insert(source, s, end, offset, head, chain);
+					s++;
+				}
+			}
+			d = WriteLiterals(source, literals, end, dest, d);
+			return d - destOffset;
+		}
+		
+		static int Hash(byte[] source, int s)
+		{
+			uint value = (uint)(source[s] | (source[s + 1] << 8) | (source[s + 2] << 16) | (source[s + 3] << 24));
+			return (int)((value * 2654435761u) >> (32 - HashBits));
+		}
+		
+		static void Insert(byte[] source, int s, int end, int offset, int[] head, int[] chain)
+		{
+			if (s + MinMatch > end) return;
+			
+			int h = Hash(source, s);
+			chain[s - offset] = head[h];
+			head[h] = s;
+		}
+		
+		static int WriteLiterals(byte[] source, int from, int to, byte[] dest, int d)
+		{
+			while (from < to)
+			{
+				int count = Math.Min(MaxLiterals, to - from);
+				dest[d++] = 0;
+				dest[d++] = (byte)(count - 1);
+				Buffer.BlockCopy(source, from, dest, d, count);
+				d += count;
+				from += count;
+			}
+			return d;
+		}
+		
+		public static unsafe byte[] Decompress(byte[] source)
+		{
+			if (source == null) throw new ArgumentNullException("source");
+			if (source.Length == 0) return Decompress(null, 0);
+			
+			fixed (byte* p = source)
+			{
+				return Decompress(p, source.Length);
+			}
+		}
+		
+		// Works on any memory, such as the pages of a PsyMappedFile.
+		public static unsafe byte[] Decompress(byte* source, int length)
+		{
+			if (length < 4) throw new InvalidDataException("z77 data is too short.");
+
+			int size = source[0] | (source[1] << 8) | (source[2] << 16) | (source[3] << 24);
+			if (size < 0) throw new InvalidDataException("z77 data has an invalid size.");
+
+			byte[] dest = new byte[size];
+			int s = 4;
+			int d = 0;
+			while (d < size)
+			{
+				if (s >= length) throw new InvalidDataException("z77 data ends before the pattern is complete.");
+				int count = source[s++];
+				if (count == 0)
+				{
+					if (s >= length) throw new InvalidDataException("z77 data ends inside a literal block.");
+					count = source[s++] + 1;
+					if (s + count > length || d + count > size) throw new InvalidDataException("z77 literal block is out of range.");
+					Marshal.Copy((IntPtr)(source + s), dest, d, count);
+					s += count;
+					d += count;
+				}
+				else
+				{
+					if (s + 2 > length) throw new InvalidDataException("z77 data ends inside a match.");
+					int distance = source[s] | (source[s + 1] << 8);
+					s += 2;
+					int from = d - distance;
+					if (distance == 0 || from < 0 || d + count > size) throw new InvalidDataException("z77 match is out of range.");
+					// Byte by byte, since a match may overlap the bytes it produces.
+					for (int i = 0; i < count; i++)
+					{
+						dest[d++] = dest[from++];
+					}
+				}
+			}
+			return dest;
+		}
+	}
+}
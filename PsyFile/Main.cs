@@ -1,16 +1,110 @@
 using System;
+using System.Collections.Generic;
+using System.IO;
 
 namespace PsyFile
 {
 	class MainClass
 	{
-		public static void Main (string[] args)
+		const string Usage = @"Usage: PsyFile [--text|--json|--yaml|--xml] [--patterns] [--samples] [--jobs N] song.psy|-
+       PsyFile [--text|--json|--yaml|--xml] [--patterns] [--samples] [--jobs N] songs-directory output-directory
+       PsyFile --psy [--columns] song.psy|-
+       PsyFile --benchmark song.psy|songs-directory";
+		
+		public static int Main (string[] args)
 		{
-			string filepath = "/home/neil/Desktop/test.psy";
+			PsyExportOptions options = new PsyExportOptions();
+			options.Format = PsyExportFormat.Text;
+			string input = null;
+			string output = null;
+			bool psy = false;
+			bool columns = false;
+			bool benchmark = false;
+			
+			for (int i = 0; i < args.Length; i++)
+			{
+				switch (args[i])
+				{
+				case "--text": options.Format = PsyExportFormat.Text; break;
+				case "--json": options.Format = PsyExportFormat.Json; break;
+				case "--yaml": options.Format = PsyExportFormat.Yaml; break;
+				case "--xml": options.Format = PsyExportFormat.Xml; break;
+				case "--psy": psy = true; break;
+				case "--columns": columns = true; break;
+				case "--benchmark": benchmark = true; break;
+				case "--patterns": options.IncludePatterns = true; break;
+				case "--samples": options.IncludeSamples = true; break;
+				case "--jobs":
+					int jobs;
+					if (++i >= args.Length || !int.TryParse(args[i], out jobs) || jobs < 1) return Fail(Usage);
+					options.MaxDegreeOfParallelism = jobs;
+					break;
+				default:
+					if (input == null) input = args[i];
+					else if (output == null) output = args[i];
+					else return Fail(Usage);
+					break;
+				}
+			}
+			if (input == null) return Fail(Usage);
+			
+			if (benchmark)
+			{
+				IEnumerable<string> files = Directory.Exists(input)
+					? Directory.EnumerateFiles(input, "*.psy", SearchOption.AllDirectories)
+					: new string[] { input };
+				new PsyCodecBenchmark().Run(files, Console.Out);
+				return 0;
+			}
+			
+			if (Directory.Exists(input))
+			{
+				if (output == null || psy) return Fail(Usage);
+				
+				PsyBatchExporter batch = new PsyBatchExporter(options);
+				int exported = batch.ExportDirectory(input, output);
+				foreach (KeyValuePair<string, Exception> error in batch.Errors)
+				{
+					Console.Error.WriteLine("{0}: {1}", error.Key, error.Value.Message);
+				}
+				Console.Error.WriteLine("Exported {0} songs, {1} failed.", exported, batch.Errors.Count);
+				return batch.Errors.Count == 0 ? 0 : 1;
+			}
+			
+			if (input != "-" && !psy)
+			{
+				new PsyExporter(options).Export(input, Console.Out);
+				return 0;
+			}
+			
+			// "-" reads the song from standard input, --psy writes it back to standard output.
 			PsyFile psyfile = new PsyFile();
-			PsyReader reader = new PsyReader(filepath, psyfile);
-			PsyWriter writer = new PsyWriter(reader.Psyfile);	
-			Console.WriteLine(writer.ToString());
+			Stream stream = input == "-" ? Console.OpenStandardInput() : File.OpenRead(input);
+			// The whole song is needed to write it back.
+			PsyReadOptions readOptions = psy ? new PsyReadOptions() : options.CreateReadOptions();
+			using (PsyReader reader = new PsyReader(stream, psyfile, readOptions))
+			{
+				if (psy)
+				{
+					using (Stream stdout = Console.OpenStandardOutput())
+					{
+						PsyBinaryWriter writer = new PsyBinaryWriter(stdout, psyfile);
+						if (columns) writer.PatternCodec = PsyPatternCodec.Columns;
+						writer.WritePsyBinary();
+					}
+				}
+				else
+				{
+					new PsyExporter(options).Export(psyfile, input, Console.Out);
+				}
+			}
+			return 0;
+		}
+		
+		static int Fail(string message)
+		{
+			Console.Error.WriteLine(message);
+			return 2;
 		}
 	}
-}
\ No newline at end of file
+}
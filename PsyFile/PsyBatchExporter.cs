@@ -0,0 +1,67 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace PsyFile
+{
+	// Exports every .psy file under a directory, several songs at a time.
+	public class PsyBatchExporter
+	{
+		protected PsyExportOptions Options;
+		
+		// Files that could not be exported, with the reason.
+		public ConcurrentDictionary<string, Exception> Errors { get; private set; }
+		
+		public PsyBatchExporter(PsyExportOptions options)
+		{
+			if (options == null) throw new ArgumentNullException("options");
+			
+			this.Options = options;
+			this.Errors = new ConcurrentDictionary<string, Exception>();
+		}
+		
+		// Writes one document per song into outputDirectory, keeping the relative paths.
+		// Returns the number of songs exported.
+		public int ExportDirectory(string inputDirectory, string outputDirectory)
+		{
+			if (!Directory.Exists(inputDirectory)) throw new DirectoryNotFoundException(inputDirectory);
+			
+			string root = Path.GetFullPath(inputDirectory);
+			IEnumerable<string> files = Directory.EnumerateFiles(root, "*.psy", SearchOption.AllDirectories);
+			ParallelOptions parallel = new ParallelOptions();
+			parallel.MaxDegreeOfParallelism = Options.MaxDegreeOfParallelism;
+			int exported = 0;
+			
+			Parallel.ForEach(files, parallel, file =>
+			{
+				string relative = file.Substring(root.Length).TrimStart(Path.DirectorySeparatorChar, Path.AltDirectorySeparatorChar);
+				string target = Path.Combine(outputDirectory, Path.ChangeExtension(relative, Options.FileExtension));
+				try
+				{
+					Directory.CreateDirectory(Path.GetDirectoryName(Path.GetFullPath(target)));
+					using (StreamWriter output = new StreamWriter(target, false, new UTF8Encoding(false)))
+					{
+						new PsyExporter(Options).Export(file, output);
+					}
+					Interlocked.Increment(ref exported);
+				}
+				catch (Exception ex)
+				{
+					Errors[file] = ex;
+					try
+					{
+						File.Delete(target);
+					}
+					catch (IOException)
+					{
+					}
+				}
+			});
+			return exported;
+		}
+	}
+}
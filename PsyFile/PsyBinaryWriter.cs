@@ -0,0 +1,393 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace PsyFile
+{
+	// Writes a PsyFile back as a PSY3SONG file, chunk by chunk in the order Song::Save uses.
+	public class PsyBinaryWriter
+	{
+		public const int CurrentVersionInfo = 0;
+		public const int CurrentVersionSngi = 1;
+		public const int CurrentVersionSeqd = 0;
+		public const int CurrentVersionPatd = 1;
+		// Major version 1 for the column codec, minor 1 for the track names as above.
+		public const int ColumnsVersionPatd = 0x0101;
+		public const int CurrentVersionInsd = 1;
+		
+		protected PsyFile Psyfile;
+		protected Stream Stream;
+		
+		// BeerZ77 by default, which psycle can read.
+		public PsyPatternCodec PatternCodec { get; set; }
+		
+		// Told about every chunk written, and checked for cancellation. Null for none.
+		public PsyProgress Progress { get; set; }
+		
+		// Chunks written in file order are assembled here, then written in one go.
+		readonly PsyChunkBuffer buffer = new PsyChunkBuffer();
+		int chunksWritten;
+		int totalChunks;
+		// Pattern cells encoded during this save, by content, so copies of a
+		// pattern are only compressed once.
+		ConcurrentDictionary<byte[], byte[]> encodedCells;
+		
+		public PsyBinaryWriter(Stream stream, PsyFile psyfile)
+		{
+			if (stream == null) throw new ArgumentNullException("stream");
+			if (psyfile == null) throw new ArgumentNullException("psyfile");
+			
+			this.Psyfile = psyfile;
+			this.Stream = stream;
+		}
+		
+		public static Task SaveInBackground(PsyFile psyfile, string path)
+		{
+			return SaveInBackground(psyfile, path, null);
+		}
+		
+		// Takes a snapshot of the song on the calling thread, then encodes and writes
+		// it on a background thread while the song keeps being edited. Errors and
+		// cancellation end up in the returned task. The song is written next to
+		// path first, so a failed save leaves the previous file as it was.
+		public static Task SaveInBackground(PsyFile psyfile, string path, PsyProgress progress)
+		{
+			if (psyfile == null) throw new ArgumentNullException("psyfile");
+			if (path == null) throw new ArgumentNullException("path");
+			
+			PsyFile snapshot = psyfile.Snapshot();
+			CancellationToken token = progress != null ? progress.CancellationToken : CancellationToken.None;
+			return Task.Factory.StartNew(() =>
+			{
+				string temp = path + ".tmp";
+				try
+				{
+					using (FileStream stream = new FileStream(temp, FileMode.Create, FileAccess.Write))
+					{
+						PsyBinaryWriter writer = new PsyBinaryWriter(stream, snapshot);
+						writer.Progress = progress;
+						writer.WritePsyBinary();
+					}
+					if (File.Exists(path))
+					{
+						File.Replace(temp, path, null);
+					}
+					else
+					{
+						File.Move(temp, path);
+					}
+				}
+				catch
+				{
+					File.Delete(temp);
+					throw;
+				}
+			}, token, TaskCreationOptions.LongRunning, TaskScheduler.Default);
+		}
+		
+		// Every chunk is assembled in memory first, so the stream is only ever
+		// written forward, one write per chunk.
+		public void WritePsyBinary()
+		{
+			List<PsyPattern> patterns = new List<PsyPattern>();
+			for (int i = 0; i < PsyFile.MaxPatterns; i++)
+			{
+				if (Psyfile.IsPatternUsed(i)) patterns.Add(Psyfile.Patterns[i]);
+			}
+			List<PsyInstrument> instruments = new List<PsyInstrument>();
+			foreach (PsyInstrument instrument in Psyfile.Instruments)
+			{
+				if (instrument != null) instruments.Add(instrument);
+			}
+			
+			// PATD and INSD chunks are encoded at the same time, each task reusing its
+			// own buffer, then written in file order.
+			byte[][] encoded = new byte[patterns.Count + instruments.Count][];
+			encodedCells = new ConcurrentDictionary<byte[], byte[]>(PsyCellsComparer.Default);
+			ParallelOptions parallel = new ParallelOptions();
+			if (Progress != null) parallel.CancellationToken = Progress.CancellationToken;
+			Parallel.For(0, encoded.Length, parallel, () => new PsyChunkBuffer(), (i, state, local) =>
+			{
+				if (i < patterns.Count)
+				{
+					encoded[i] = EncodePattern(local, patterns[i]);
+				}
+				else
+				{
+					WriteInstrument(local, instruments[i - patterns.Count]);
+					encoded[i] = local.ToArray();
+				}
+				return local;
+			}, local => { });
+			
+			int chunkcount = 3 + encoded.Length; // INFO, SNGI, SEQD
+			foreach (PsyChunk chunk in Psyfile.Chunks)
+			{
+				if (chunk.Data != null) chunkcount++;
+			}
+			chunksWritten = 0;
+			totalChunks = chunkcount;
+			
+			buffer.Clear();
+			WriteId(buffer.Writer, "PSY3SONG");
+			buffer.Writer.Write(Psyfile.ChunkVersion);
+			buffer.Writer.Write(sizeof(int));
+			buffer.Writer.Write(chunkcount);
+			buffer.WriteTo(Stream);
+			
+			WriteSongBasicInfo(buffer);
+			WriteChunk(buffer);
+			WriteSongProperties(buffer);
+			WriteChunk(buffer);
+			WriteSequence(buffer);
+			WriteChunk(buffer);
+			for (int i = 0; i < patterns.Count; i++)
+			{
+				WriteChunk(encoded[i]);
+			}
+			WriteRawChunks("MACD");
+			for (int i = patterns.Count; i < encoded.Length; i++)
+			{
+				WriteChunk(encoded[i]);
+			}
+			WriteRawChunks("EINS");
+			Stream.Flush();
+		}
+		
+		void WriteChunk(PsyChunkBuffer chunk)
+		{
+			chunk.WriteTo(Stream);
+			ReportChunk();
+		}
+		
+		void WriteChunk(byte[] chunk)
+		{
+			Stream.Write(chunk, 0, chunk.Length);
+			ReportChunk();
+		}
+		
+		void ReportChunk()
+		{
+			chunksWritten++;
+			if (Progress != null) Progress.Report(chunksWritten, totalChunks);
+		}
+		
+		// Patterns that did not change since the last save keep their cached chunk.
+		byte[] EncodePattern(PsyChunkBuffer chunk, PsyPattern pattern)
+		{
+			// The chunk also depends on the codec and how the song stores track names.
+			int context = (Psyfile.Tracks * 2 + (int)PatternCodec) * 2 + (Psyfile.ShareTrackNames ? 1 : 0);
+			int revision = pattern.Revision;
+			byte[] bytes = pattern.EncodedChunk.Get(revision, context);
+			if (bytes == null)
+			{
+				WritePattern(chunk, pattern);
+				bytes = chunk.ToArray();
+				pattern.EncodedChunk.Set(revision, context, bytes);
+			}
+			return bytes;
+		}
+		
+		void WriteSongBasicInfo(PsyChunkBuffer chunk)
+		{
+			BinaryWriter writer = chunk.Begin("INFO", CurrentVersionInfo);
+			WriteString(writer, Psyfile.Title);
+			WriteString(writer, Psyfile.Artist);
+			WriteString(writer, Psyfile.Comments);
+			chunk.End();
+		}
+		
+		void WriteSongProperties(PsyChunkBuffer chunk)
+		{
+			int tracks = Psyfile.Tracks;
+			BinaryWriter writer = chunk.Begin("SNGI", CurrentVersionSngi);
+			writer.Write(PsyLayouts.SongProperties.Encode(Psyfile));
+			writer.Write(PsyLayouts.EncodeTrackFlags(tracks, Psyfile.TrackMuted, Psyfile.TrackArmed));
+			writer.Write(Psyfile.ShareTrackNames);
+			if (Psyfile.ShareTrackNames) WriteTrackNames(writer, Psyfile.TrackNames);
+			chunk.End();
+		}
+		
+		void WriteSequence(PsyChunkBuffer chunk)
+		{
+			BinaryWriter writer = chunk.Begin("SEQD", CurrentVersionSeqd);
+			writer.Write(0); // index
+			writer.Write(Psyfile.PlayOrder.Length);
+			WriteString(writer, Psyfile.SequenceName ?? "seq0");
+			writer.Write(PsyLayouts.EncodeInt32s(Psyfile.PlayOrder));
+			chunk.End();
+		}
+		
+		void WritePattern(PsyChunkBuffer chunk, PsyPattern pattern)
+		{
+			bool columns = PatternCodec == PsyPatternCodec.Columns;
+			BinaryWriter writer = chunk.Begin("PATD", columns ? ColumnsVersionPatd : CurrentVersionPatd);
+			writer.Write(pattern.Index);
+			writer.Write(pattern.Lines);
+			// Song::Load reads every line with the song's track count, so the
+			// lines of a pattern with fewer or more tracks are padded or cut.
+			int tracks = Psyfile.Tracks;
+			bool sameTracks = pattern.Tracks == tracks;
+			writer.Write(tracks);
+			WriteString(writer, pattern.Name);
+			
+			// A pattern still packed as it was loaded is written without recompressing it.
+			byte[] z77 = columns || !sameTracks ? null : pattern.Packed;
+			if (z77 != null)
+			{
+				writer.Write(z77.Length);
+				writer.Write(z77);
+			}
+			else
+			{
+				// Compressed straight into the chunk, the size is filled in afterwards.
+				int sizeOffset = chunk.Length;
+				writer.Write(0);
+				int offset;
+				int size;
+				byte[] packed;
+				PsySparseCells sparse = pattern.Sparse;
+				byte[] data = columns && sparse != null && sameTracks ? null : pattern.GetCells(tracks);
+				if (data == null)
+				{
+					byte[] bytes = chunk.Reserve(PsyColumnCodec.MaxEncodedSize(sparse.Size), out offset);
+					size = PsyColumnCodec.Encode(sparse, bytes, offset);
+				}
+				else if (encodedCells.TryGetValue(data, out packed))
+				{
+					byte[] bytes = chunk.Reserve(packed.Length, out offset);
+					Buffer.BlockCopy(packed, 0, bytes, offset, packed.Length);
+					size = packed.Length;
+				}
+				else
+				{
+					byte[] bytes;
+					if (columns)
+					{
+						bytes = chunk.Reserve(PsyColumnCodec.MaxEncodedSize(data.Length), out offset);
+						size = PsyColumnCodec.Encode(data, 0, data.Length, bytes, offset);
+					}
+					else
+					{
+						bytes = chunk.Reserve(BeerZ77.MaxCompressedSize(data.Length), out offset);
+						size = BeerZ77.Compress(data, 0, data.Length, bytes, offset);
+					}
+					// Throws if the codec went past what was reserved, before anything is kept.
+					chunk.Trim(offset + size);
+					packed = new byte[size];
+					Buffer.BlockCopy(bytes, offset, packed, 0, size);
+					encodedCells.TryAdd(data, packed);
+				}
+				chunk.Trim(offset + size);
+				chunk.Patch(sizeOffset, size);
+			}
+			if (!Psyfile.ShareTrackNames) WriteTrackNames(writer, pattern.TrackNames);
+			chunk.End();
+		}
+		
+		// Header and body in one write, the body is already in memory.
+		void WriteRawChunks(string id)
+		{
+			foreach (PsyChunk chunk in Psyfile.Chunks)
+			{
+				if (chunk.Id != id || chunk.Data == null) continue;
+				
+				buffer.Clear();
+				WriteId(buffer.Writer, chunk.Id);
+				buffer.Writer.Write(chunk.Version);
+				buffer.Writer.Write(chunk.Data.Length);
+				buffer.WriteTo(Stream);
+				WriteChunk(chunk.Data);
+			}
+		}
+		
+		void WriteInstrument(PsyChunkBuffer chunk, PsyInstrument instrument)
+		{
+			BinaryWriter writer = chunk.Begin("INSD", CurrentVersionInsd);
+			writer.Write(instrument.Index);
+			writer.Write(instrument.Loop);
+			writer.Write(instrument.Lines);
+			writer.Write((byte)instrument.NNA);
+			writer.Write(instrument.EnvAttack);
+			writer.Write(instrument.EnvDecay);
+			writer.Write(instrument.EnvSustain);
+			writer.Write(instrument.EnvRelease);
+			writer.Write(instrument.FilterEnvAttack);
+			writer.Write(instrument.FilterEnvDecay);
+			writer.Write(instrument.FilterEnvSustain);
+			writer.Write(instrument.FilterEnvRelease);
+			writer.Write(instrument.FilterCutoff);
+			writer.Write(instrument.FilterResonance);
+			writer.Write(instrument.FilterAmount);
+			writer.Write(instrument.FilterType);
+			writer.Write(instrument.Panning);
+			writer.Write(instrument.RandomPan);
+			writer.Write(instrument.RandomCutoff);
+			writer.Write(instrument.RandomResonance);
+			WriteString(writer, instrument.Name);
+			writer.Write(instrument.Waves.Count);
+			foreach (PsyWave wave in instrument.Waves)
+			{
+				WriteWave(writer, wave);
+			}
+			writer.Write(instrument.LockInstrument);
+			writer.Write(instrument.UseLock);
+			chunk.End();
+		}
+		
+		void WriteWave(BinaryWriter writer, PsyWave wave)
+		{
+			byte[] left = wave.PackedLeft ?? new byte[0];
+			byte[] right = wave.PackedRight ?? new byte[0];
+			int size = 7 * sizeof(int) + sizeof(short) + 2 * sizeof(bool) + StringSize(wave.Name) + left.Length;
+			if (wave.Stereo) size += sizeof(int) + right.Length;
+			
+			writer.Write(0); // version
+			writer.Write(size);
+			writer.Write(wave.Index);
+			writer.Write(wave.Length);
+			writer.Write((ushort)wave.Volume);
+			writer.Write(wave.LoopStart);
+			writer.Write(wave.LoopEnd);
+			writer.Write(wave.Tune);
+			writer.Write(wave.Finetune);
+			writer.Write(wave.Loop);
+			writer.Write(wave.Stereo);
+			WriteString(writer, wave.Name);
+			writer.Write(left.Length);
+			writer.Write(left);
+			if (wave.Stereo)
+			{
+				writer.Write(right.Length);
+				writer.Write(right);
+			}
+		}
+		
+		static void WriteId(BinaryWriter writer, string id)
+		{
+			writer.Write(PsyFile.StringEncoding.GetBytes(id));
+		}
+		
+		static void WriteString(BinaryWriter writer, string value)
+		{
+			writer.Write(PsyFile.StringEncoding.GetBytes(value ?? ""));
+			writer.Write((byte)0);
+		}
+		
+		void WriteTrackNames(BinaryWriter writer, string[] names)
+		{
+			for (int t = 0; t < Psyfile.Tracks; t++)
+			{
+				WriteString(writer, names != null && t < names.Length ? names[t] : "");
+			}
+		}
+		
+		static int StringSize(string value)
+		{
+			return PsyFile.StringEncoding.GetByteCount(value ?? "") + 1;
+		}
+	}
+}
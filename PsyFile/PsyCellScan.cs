@@ -0,0 +1,120 @@
+using System;
+
+namespace PsyFile
+{
+	// Finds the cells of a pattern that are not blank. Eight cells make 40 bytes,
+	// five 64 bit words, so the blank cell repeated eight times is compared a word
+	// at a time and a whole block of blank cells costs five compares. Blocks that
+	// differ, and the cells after the last whole block, are checked cell by cell.
+	public static class PsyCellScan
+	{
+		const int BlockCells = 8;
+		const int BlockSize = BlockCells * PsyFile.EventSize;
+
+		static readonly ulong blank0, blank1, blank2, blank3, blank4;
+
+		static unsafe PsyCellScan()
+		{
+			byte[] block = new byte[BlockSize];
+			PsyPattern.FillBlank(block, 0, block.Length);
+			fixed (byte* p = block)
+			{
+				ulong* words = (ulong*)p;
+				blank0 = words[0];
+				blank1 = words[1];
+				blank2 = words[2];
+				blank3 = words[3];
+				blank4 = words[4];
+			}
+		}
+
+		// Index, from offset, of the first cell that is not blank, or -1.
+		public static unsafe int FirstUsed(byte[] cells, int offset, int count)
+		{
+			CheckRange(cells, offset, count);
+
+			int total = count / PsyFile.EventSize;
+			fixed (byte* start = cells)
+			{
+				byte* p = start + offset;
+				int cell = 0;
+				for (; cell + BlockCells <= total; cell += BlockCells, p += BlockSize)
+				{
+					if (IsBlankBlock(p)) continue;
+					for (int i = 0; i < BlockCells; i++)
+					{
+						if (!IsBlank(p + i * PsyFile.EventSize)) return cell + i;
+					}
+				}
+				for (; cell < total; cell++, p += PsyFile.EventSize)
+				{
+					if (!IsBlank(p)) return cell;
+				}
+			}
+			return -1;
+		}
+
+		// Number of cells from offset that are not blank.
+		public static unsafe int CountUsed(byte[] cells, int offset, int count)
+		{
+			CheckRange(cells, offset, count);
+
+			int total = count / PsyFile.EventSize;
+			int used = 0;
+			fixed (byte* start = cells)
+			{
+				byte* p = start + offset;
+				int cell = 0;
+				for (; cell + BlockCells <= total; cell += BlockCells, p += BlockSize)
+				{
+					if (IsBlankBlock(p)) continue;
+					for (int i = 0; i < BlockCells; i++)
+					{
+						if (!IsBlank(p + i * PsyFile.EventSize)) used++;
+					}
+				}
+				for (; cell < total; cell++, p += PsyFile.EventSize)
+				{
+					if (!IsBlank(p)) used++;
+				}
+			}
+			return used;
+		}
+
+		// The same answers, one cell at a time, as the scan in Song::IsPatternEmpty.
+		// Kept for the benchmark.
+		public static int CountUsedByCell(byte[] cells, int offset, int count)
+		{
+			CheckRange(cells, offset, count);
+
+			int used = 0;
+			for (int s = offset, end = offset + count - count % PsyFile.EventSize; s < end; s += PsyFile.EventSize)
+			{
+				if (cells[s] != PsyPattern.EmptyNote || cells[s + 1] != PsyPattern.EmptyInst || cells[s + 2] != PsyPattern.EmptyMach
+					|| cells[s + 3] != 0 || cells[s + 4] != 0)
+				{
+					used++;
+				}
+			}
+			return used;
+		}
+
+		static void CheckRange(byte[] cells, int offset, int count)
+		{
+			if (cells == null) throw new ArgumentNullException("cells");
+			if (offset < 0 || count < 0 || offset + count > cells.Length) throw new ArgumentOutOfRangeException("count");
+		}
+
+		// Unaligned reads, which the x86 and x64 hosts this runs on allow.
+		static unsafe bool IsBlankBlock(byte* p)
+		{
+			ulong* words = (ulong*)p;
+			return ((words[0] ^ blank0) | (words[1] ^ blank1) | (words[2] ^ blank2) | (words[3] ^ blank3) | (words[4] ^ blank4)) == 0;
+		}
+
+		static unsafe bool IsBlank(byte* p)
+		{
+			return p[0] == PsyPattern.EmptyNote && p[1] == PsyPattern.EmptyInst && p[2] == PsyPattern.EmptyMach && p[3] == 0 && p[4] == 0;
+		}
+	}
+}
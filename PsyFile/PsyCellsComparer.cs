@@ -0,0 +1,52 @@
+using System;
+using System.Collections.Generic;
+
+namespace PsyFile
+{
+	// Compares pattern cells by content, so that copies of a pattern can be found
+	// with a dictionary. The hash reads eight bytes at a time.
+	public class PsyCellsComparer : IEqualityComparer<byte[]>
+	{
+		public static readonly PsyCellsComparer Default = new PsyCellsComparer();
+
+		public unsafe bool Equals(byte[] x, byte[] y)
+		{
+			if (ReferenceEquals(x, y)) return true;
+			if (x == null || y == null || x.Length != y.Length) return false;
+
+			fixed (byte* px = x, py = y)
+			{
+				int i = 0;
+				for (; i + sizeof(ulong) <= x.Length; i += sizeof(ulong))
+				{
+					if (*(ulong*)(px + i) != *(ulong*)(py + i)) return false;
+				}
+				for (; i < x.Length; i++)
+				{
+					if (px[i] != py[i]) return false;
+				}
+			}
+			return true;
+		}
+
+		public unsafe int GetHashCode(byte[] cells)
+		{
+			if (cells == null) return 0;
+
+			ulong hash = 14695981039346656037ul ^ (ulong)cells.Length;
+			fixed (byte* p = cells)
+			{
+				int i = 0;
+				for (; i + sizeof(ulong) <= cells.Length; i += sizeof(ulong))
+				{
+					hash = (hash ^ *(ulong*)(p + i)) * 1099511628211ul;
+				}
+				for (; i < cells.Length; i++)
+				{
+					hash = (hash ^ p[i]) * 1099511628211ul;
+				}
+			}
+			return (int)(hash ^ (hash >> 32));
+		}
+	}
+}
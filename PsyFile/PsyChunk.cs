@@ -0,0 +1,58 @@
+using System;
+
+namespace PsyFile
+{
+	// Table of contents entry for one chunk of a PSY3SONG file.
+	public class PsyChunk
+	{
+		public string Id { get; set; }
+		public int Version { get; set; }
+		public int Size { get; set; }
+
+		// Position of the chunk data, just after the header.
+		public long Offset { get; set; }
+		
+		// Body of the chunks that are not decoded into the model (MACD, EINS),
+		// kept so that PsyBinaryWriter can write them back unchanged.
+		public byte[] Data { get; set; }
+
+		public PsyChunk ()
+		{
+		}
+
+		// Only the major version zero layouts are understood, same as in Song::Load.
+		public bool IsMajorZero
+		{
+			get { return (Version & 0xFF00) == 0; }
+		}
+
+		public PsyChunkKinds Kind
+		{
+			get
+			{
+				switch (Id)
+				{
+				case "INFO": return PsyChunkKinds.Info;
+				case "SNGI": return PsyChunkKinds.SongProperties;
+				case "SEQD": return PsyChunkKinds.Sequence;
+				case "PATD": return PsyChunkKinds.Patterns;
+				case "MACD": return PsyChunkKinds.Machines;
+				case "INSD": return PsyChunkKinds.Instruments;
+				case "EINS": return PsyChunkKinds.XMInstruments;
+				default: return PsyChunkKinds.None;
+				}
+			}
+		}
+
+		// Data is shared, it is only ever replaced.
+		public PsyChunk Snapshot()
+		{
+			return (PsyChunk)MemberwiseClone();
+		}
+
+		public override string ToString ()
+		{
+			return string.Format ("[PsyChunk: Id={0}, Version={1}, Size={2}, Offset={3}]", Id, Version, Size, Offset);
+		}
+	}
+}
@@ -0,0 +1,99 @@
+using System;
+using System.IO;
+
+namespace PsyFile
+{
+	// Assembles one chunk in memory so that its size is known before anything is
+	// written out. The buffer is kept between chunks and only grows.
+	public class PsyChunkBuffer
+	{
+		const int HeaderSize = 12;
+		
+		readonly MemoryStream buffer;
+		
+		public PsyChunkBuffer ()
+		{
+			buffer = new MemoryStream();
+			Writer = new BinaryWriter(buffer);
+		}
+		
+		// Writes into the buffer, after the chunk header.
+		public BinaryWriter Writer { get; private set; }
+		
+		public int Length
+		{
+			get
+			{
+				Writer.Flush();
+				return (int)buffer.Length;
+			}
+		}
+		
+		// Starts a new chunk, dropping the previous one. The size is filled in by End.
+		public BinaryWriter Begin(string id, int version)
+		{
+			Clear();
+			Writer.Write(PsyFile.StringEncoding.GetBytes(id));
+			Writer.Write(version);
+			Writer.Write(0);
+			return Writer;
+		}
+		
+		public void End()
+		{
+			Writer.Flush();
+			Patch(8, (int)buffer.Length - HeaderSize);
+		}
+		
+		// Makes room for count bytes at the end, for callers that write into the
+		// returned array directly from offset. Trim drops what they did not use.
+		public byte[] Reserve(int count, out int offset)
+		{
+			Writer.Flush();
+			offset = (int)buffer.Length;
+			buffer.SetLength(offset + count);
+			return buffer.GetBuffer();
+		}
+		
+		// Only ever shrinks: a length past what was reserved means the caller wrote
+		// over the end, and growing would zero what it wrote there.
+		public void Trim(int length)
+		{
+			Writer.Flush();
+			if (length < 0 || length > buffer.Length) throw new InvalidOperationException("More bytes were written than were reserved.");
+			buffer.SetLength(length);
+			buffer.Position = length;
+		}
+		
+		// Overwrites an int already in the buffer.
+		public void Patch(int offset, int value)
+		{
+			Writer.Flush();
+			byte[] bytes = buffer.GetBuffer();
+			bytes[offset] = (byte)value;
+			bytes[offset + 1] = (byte)(value >> 8);
+			bytes[offset + 2] = (byte)(value >> 16);
+			bytes[offset + 3] = (byte)(value >> 24);
+		}
+		
+		// For data that is not a chunk, such as the file header.
+		public void Clear()
+		{
+			Writer.Flush();
+			buffer.SetLength(0);
+		}
+		
+		// The whole chunk in one write.
+		public void WriteTo(Stream stream)
+		{
+			Writer.Flush();
+			stream.Write(buffer.GetBuffer(), 0, (int)buffer.Length);
+		}
+		
+		public byte[] ToArray()
+		{
+			Writer.Flush();
+			return buffer.ToArray();
+		}
+	}
+}
@@ -0,0 +1,46 @@
+using System;
+
+namespace PsyFile
+{
+	// The encoded bytes of one chunk, valid for as long as the object they were
+	// encoded from stays at the same revision and the song context is the same.
+	public class PsyChunkCache
+	{
+		int revision;
+		int context;
+		byte[] chunk;
+		readonly object sync = new object();
+		
+		public PsyChunkCache ()
+		{
+		}
+		
+		// Null when nothing was cached for this revision and context.
+		public byte[] Get(int revision, int context)
+		{
+			lock (sync)
+			{
+				if (chunk == null || this.revision != revision || this.context != context) return null;
+				return chunk;
+			}
+		}
+		
+		public void Set(int revision, int context, byte[] chunk)
+		{
+			lock (sync)
+			{
+				this.revision = revision;
+				this.context = context;
+				this.chunk = chunk;
+			}
+		}
+		
+		public void Clear()
+		{
+			lock (sync)
+			{
+				chunk = null;
+			}
+		}
+	}
+}
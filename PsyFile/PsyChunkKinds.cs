@@ -0,0 +1,19 @@
+using System;
+
+namespace PsyFile
+{
+	// Chunks that PsyReader decodes, see PsyReadOptions.Chunks.
+	[Flags]
+	public enum PsyChunkKinds
+	{
+		None = 0,
+		Info = 1,			// INFO
+		SongProperties = 2,	// SNGI
+		Sequence = 4,		// SEQD
+		Patterns = 8,		// PATD
+		Machines = 16,		// MACD
+		Instruments = 32,	// INSD
+		XMInstruments = 64,	// EINS
+		All = Info | SongProperties | Sequence | Patterns | Machines | Instruments | XMInstruments
+	}
+}
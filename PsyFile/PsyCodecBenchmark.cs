@@ -0,0 +1,125 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+
+namespace PsyFile
+{
+	// Compares BeerZ77 with PsyColumnCodec on the patterns of real songs: encode
+	// and decode throughput over the unpacked bytes, and the packed size. Also
+	// times PsyCellScan against checking the cells one by one.
+	public class PsyCodecBenchmark
+	{
+		// Each codec runs over all patterns this many times, the best run counts.
+		public int Iterations { get; set; }
+		
+		public PsyCodecBenchmark ()
+		{
+			Iterations = 5;
+		}
+		
+		// Songs that cannot be read are reported and left out.
+		public void Run(IEnumerable<string> files, TextWriter output)
+		{
+			if (files == null) throw new ArgumentNullException("files");
+			if (output == null) throw new ArgumentNullException("output");
+			
+			List<byte[]> patterns = new List<byte[]>();
+			int songs = 0;
+			foreach (string file in files)
+			{
+				try
+				{
+					PsyReadOptions options = new PsyReadOptions();
+					options.Chunks = PsyChunkKinds.SongProperties | PsyChunkKinds.Patterns;
+					PsyFile psyfile = new PsyFile();
+					using (PsyReader reader = new PsyReader(file, psyfile, options))
+					{
+						foreach (PsyPattern pattern in psyfile.Patterns)
+						{
+							if (pattern != null && pattern.Data != null) patterns.Add(pattern.Data);
+						}
+					}
+					songs++;
+				}
+				catch (Exception ex)
+				{
+					output.WriteLine("{0}: {1}", file, ex.Message);
+				}
+			}
+			
+			long bytes = 0;
+			foreach (byte[] data in patterns) bytes += data.Length;
+			output.WriteLine("{0} patterns from {1} songs, {2} bytes unpacked.", patterns.Count, songs, bytes);
+			if (bytes == 0) return;
+			
+			output.WriteLine("{0,-10} {1,12} {2,8} {3,14} {4,14}", "Codec", "Packed", "Ratio", "Encode MB/s", "Decode MB/s");
+			Measure("BeerZ77", patterns, bytes, BeerZ77.Compress, BeerZ77.Decompress, output);
+			Measure("Columns", patterns, bytes, PsyColumnCodec.Encode, PsyColumnCodec.Decode, output);
+			
+			output.WriteLine();
+			output.WriteLine("{0,-10} {1,12} {2,14}", "Scan", "Used cells", "MB/s");
+			MeasureScan("By cell", patterns, bytes, PsyCellScan.CountUsedByCell, output);
+			MeasureScan("Blocks", patterns, bytes, PsyCellScan.CountUsed, output);
+		}
+		
+		void MeasureScan(string name, List<byte[]> patterns, long bytes, Func<byte[], int, int, int> count, TextWriter output)
+		{
+			long used = 0;
+			double seconds = double.MaxValue;
+			for (int n = 0; n < Iterations; n++)
+			{
+				used = 0;
+				Stopwatch clock = Stopwatch.StartNew();
+				foreach (byte[] data in patterns)
+				{
+					used += count(data, 0, data.Length);
+				}
+				seconds = Math.Min(seconds, clock.Elapsed.TotalSeconds);
+			}
+			output.WriteLine("{0,-10} {1,12} {2,14:0.0}", name, used, bytes / seconds / (1 << 20));
+		}
+		
+		void Measure(string name, List<byte[]> patterns, long bytes, Func<byte[], byte[]> encode, Func<byte[], byte[]> decode, TextWriter output)
+		{
+			byte[][] packed = new byte[patterns.Count][];
+			long packedBytes = 0;
+			double encodeSeconds = double.MaxValue;
+			double decodeSeconds = double.MaxValue;
+			for (int n = 0; n < Iterations; n++)
+			{
+				Stopwatch clock = Stopwatch.StartNew();
+				for (int i = 0; i < packed.Length; i++)
+				{
+					packed[i] = encode(patterns[i]);
+				}
+				encodeSeconds = Math.Min(encodeSeconds, clock.Elapsed.TotalSeconds);
+				
+				clock = Stopwatch.StartNew();
+				for (int i = 0; i < packed.Length; i++)
+				{
+					decode(packed[i]);
+				}
+				decodeSeconds = Math.Min(decodeSeconds, clock.Elapsed.TotalSeconds);
+			}
+			
+			for (int i = 0; i < packed.Length; i++)
+			{
+				packedBytes += packed[i].Length;
+				if (!Equal(decode(packed[i]), patterns[i])) throw new InvalidDataException(name + " does not decode to the same pattern.");
+			}
+			output.WriteLine("{0,-10} {1,12} {2,8:0.00} {3,14:0.0} {4,14:0.0}", name, packedBytes, (double)bytes / packedBytes,
+				bytes / encodeSeconds / (1 << 20), bytes / decodeSeconds / (1 << 20));
+		}
+		
+		static bool Equal(byte[] a, byte[] b)
+		{
+			if (a.Length != b.Length) return false;
+			for (int i = 0; i < a.Length; i++)
+			{
+				if (a[i] != b[i]) return false;
+			}
+			return true;
+		}
+	}
+}
@@ -0,0 +1,209 @@
+using System;
+using System.IO;
+
+namespace PsyFile
+{
+	// Pattern codec for the column coded PATD chunks. Blank cells are left out,
+	// and the other cells are split into one plane per PatternEntry field (every
+	// note, then every aux, ...), each run length coded. Patterns are mostly
+	// blank, and the machine and command columns mostly repeat one value.
+	//
+	// uint32 unpacked size
+	// varint count of the cells that are not blank
+	// varint per such cell: how many blank cells come before it
+	// for each of the EventSize planes, tokens until the plane is complete:
+	//   varint (count << 1)        count literal bytes
+	//   varint (count << 1) | 1    one byte, repeated count times
+	public static class PsyColumnCodec
+	{
+		const int MinRun = 3;
+		const int MaxVarintSize = 5;
+		
+		public static byte[] Encode(byte[] source)
+		{
+			if (source == null) throw new ArgumentNullException("source");
+			
+			byte[] dest = new byte[MaxEncodedSize(source.Length)];
+			int length = Encode(source, 0, source.Length, dest, 0);
+			byte[] result = new byte[length];
+			Buffer.BlockCopy(dest, 0, result, 0, length);
+			return result;
+		}
+		
+		// Room Encode needs for count bytes: the cell list, and the planes, whose
+		// runs always take less room than the bytes they replace.
+		public static int MaxEncodedSize(int count)
+		{
+			int cells = count / PsyFile.EventSize;
+			return 4 + MaxVarintSize * (cells + 1) + count + count / MinRun + PsyFile.EventSize * MaxVarintSize;
+		}
+		
+		// Encodes count bytes of whole cells into dest, which needs MaxEncodedSize(count)
+		// bytes from destOffset, and returns the encoded length.
+		public static int Encode(byte[] source, int offset, int count, byte[] dest, int destOffset)
+		{
+			if (source == null) throw new ArgumentNullException("source");
+			if (dest == null) throw new ArgumentNullException("dest");
+			if (offset < 0 || count < 0 || offset + count > source.Length) throw new ArgumentOutOfRangeException("count");
+			if (count % PsyFile.EventSize != 0) throw new ArgumentException("Not a whole number of cells.", "count");
+			if (destOffset < 0 || destOffset + MaxEncodedSize(count) > dest.Length) throw new ArgumentOutOfRangeException("destOffset");
+			
+			// Indexes and offsets of the cells that are not blank.
+			int cells = count / PsyFile.EventSize;
+			int[] indexes = new int[cells];
+			int[] used = new int[cells];
+			int usedCount = 0;
+			for (int i = 0, s = offset; i < cells; i++, s += PsyFile.EventSize)
+			{
+				if (source[s] != PsyPattern.EmptyNote || source[s + 1] != PsyPattern.EmptyInst || source[s + 2] != PsyPattern.EmptyMach
+					|| source[s + 3] != 0 || source[s + 4] != 0)
+				{
+					indexes[usedCount] = i;
+					used[usedCount++] = s;
+				}
+			}
+			return Encode(count, indexes, used, usedCount, source, dest, destOffset);
+		}
+		
+		// Encodes a sparse pattern without making it dense first.
+		public static int Encode(PsySparseCells sparse, byte[] dest, int destOffset)
+		{
+			if (sparse == null) throw new ArgumentNullException("sparse");
+			if (dest == null) throw new ArgumentNullException("dest");
+			if (destOffset < 0 || destOffset + MaxEncodedSize(sparse.Size) > dest.Length) throw new ArgumentOutOfRangeException("destOffset");
+			
+			int[] used = new int[sparse.Count];
+			for (int i = 0; i < used.Length; i++) used[i] = i * PsyFile.EventSize;
+			return Encode(sparse.Size, sparse.Cells, used, used.Length, sparse.Events, dest, destOffset);
+		}
+		
+		// The cells that are not blank: their index, and the offset of their bytes in source.
+		static int Encode(int count, int[] indexes, int[] used, int usedCount, byte[] source, byte[] dest, int destOffset)
+		{
+			int d = destOffset;
+			dest[d++] = (byte)count;
+			dest[d++] = (byte)(count >> 8);
+			dest[d++] = (byte)(count >> 16);
+			dest[d++] = (byte)(count >> 24);
+			
+			d = WriteVarint(dest, d, (uint)usedCount);
+			int next = 0;
+			for (int i = 0; i < usedCount; i++)
+			{
+				d = WriteVarint(dest, d, (uint)(indexes[i] - next));
+				next = indexes[i] + 1;
+			}
+			
+			for (int plane = 0; plane < PsyFile.EventSize; plane++)
+			{
+				int literals = 0;
+				int i = 0;
+				while (i < usedCount)
+				{
+					byte value = source[used[i] + plane];
+					int run = 1;
+					while (i + run < usedCount && source[used[i + run] + plane] == value) run++;
+					
+					if (run >= MinRun)
+					{
+						d = WriteLiterals(source, used, plane, literals, i, dest, d);
+						d = WriteVarint(dest, d, ((uint)run << 1) | 1);
+						dest[d++] = value;
+						literals = i + run;
+					}
+					i += run;
+				}
+				d = WriteLiterals(source, used, plane, literals, usedCount, dest, d);
+			}
+			return d - destOffset;
+		}
+		
+		static int WriteLiterals(byte[] source, int[] used, int plane, int from, int to, byte[] dest, int d)
+		{
+			if (from == to) return d;
+			
+			d = WriteVarint(dest, d, (uint)(to - from) << 1);
+			for (int i = from; i < to; i++)
+			{
+				dest[d++] = source[used[i] + plane];
+			}
+			return d;
+		}
+		
+		static int WriteVarint(byte[] dest, int d, uint value)
+		{
+			while (value >= 0x80)
+			{
+				dest[d++] = (byte)(value | 0x80);
+				value >>= 7;
+			}
+			dest[d++] = (byte)value;
+			return d;
+		}
+		
+		public static byte[] Decode(byte[] source)
+		{
+			if (source == null) throw new ArgumentNullException("source");
+			if (source.Length < 4) throw new InvalidDataException("Column coded data is too short.");
+			
+			int size = source[0] | (source[1] << 8) | (source[2] << 16) | (source[3] << 24);
+			if (size < 0 || size % PsyFile.EventSize != 0) throw new InvalidDataException("Column coded data has an invalid size.");
+			
+			byte[] dest = new byte[size];
+			PsyPattern.FillBlank(dest, 0, dest.Length);
+			
+			int s = 4;
+			int cells = size / PsyFile.EventSize;
+			uint usedCount = ReadVarint(source, ref s);
+			if (usedCount > cells) throw new InvalidDataException("Column coded data has too many cells.");
+			
+			int[] used = new int[usedCount];
+			long next = 0;
+			for (int i = 0; i < used.Length; i++)
+			{
+				next += ReadVarint(source, ref s);
+				if (next >= cells) throw new InvalidDataException("Column coded cell is out of range.");
+				used[i] = (int)next * PsyFile.EventSize;
+				next++;
+			}
+			
+			for (int plane = 0; plane < PsyFile.EventSize; plane++)
+			{
+				int i = 0;
+				while (i < used.Length)
+				{
+					uint token = ReadVarint(source, ref s);
+					long count = token >> 1;
+					if (count == 0 || i + count > used.Length) throw new InvalidDataException("Column coded run is out of range.");
+					
+					int end = i + (int)count;
+					if ((token & 1) != 0)
+					{
+						if (s >= source.Length) throw new InvalidDataException("Column coded data ends inside a run.");
+						byte value = source[s++];
+						for (; i < end; i++) dest[used[i] + plane] = value;
+					}
+					else
+					{
+						if (s + count > source.Length) throw new InvalidDataException("Column coded data ends inside a literal block.");
+						for (; i < end; i++) dest[used[i] + plane] = source[s++];
+					}
+				}
+			}
+			return dest;
+		}
+		
+		static uint ReadVarint(byte[] source, ref int s)
+		{
+			uint value = 0;
+			for (int shift = 0; shift < 32; shift += 7)
+			{
+				if (s >= source.Length) throw new InvalidDataException("Column coded data ends inside a token.");
+				byte b = source[s++];
+				value |= (uint)(b & 0x7F) << shift;
+				if (b < 0x80) return value;
+			}
+			throw new InvalidDataException("Column coded token is too long.");
+		}
+	}
+}
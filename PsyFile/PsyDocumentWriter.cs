@@ -0,0 +1,42 @@
+using System;
+using System.IO;
+
+namespace PsyFile
+{
+	// Streaming writer for structured documents. Values are written out as soon as
+	// they are given, nothing is kept in memory but the current nesting.
+	// Names are ignored for the items of an array.
+	public abstract class PsyDocumentWriter : IDisposable
+	{
+		protected TextWriter Output;
+		
+		protected PsyDocumentWriter(TextWriter output)
+		{
+			if (output == null) throw new ArgumentNullException("output");
+			
+			this.Output = output;
+		}
+		
+		public abstract void BeginDocument();
+		public abstract void EndDocument();
+		public abstract void BeginObject(string name);
+		public abstract void EndObject();
+		public abstract void BeginArray(string name);
+		public abstract void EndArray();
+		public abstract void WriteValue(string name, string value);
+		public abstract void WriteValue(string name, long value);
+		public abstract void WriteValue(string name, double value);
+		public abstract void WriteValue(string name, bool value);
+		
+		public void Dispose()
+		{
+			Dispose(true);
+			GC.SuppressFinalize(this);
+		}
+		
+		protected virtual void Dispose(bool disposing)
+		{
+			if (disposing) Output.Dispose();
+		}
+	}
+}
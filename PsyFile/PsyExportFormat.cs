@@ -0,0 +1,12 @@
+using System;
+
+namespace PsyFile
+{
+	public enum PsyExportFormat
+	{
+		Text,
+		Json,
+		Yaml,
+		Xml
+	}
+}
@@ -0,0 +1,48 @@
+using System;
+
+namespace PsyFile
+{
+	public class PsyExportOptions
+	{
+		public PsyExportFormat Format { get; set; }
+		
+		// Write the notes of every pattern. Without it PATD chunks are not even decoded.
+		public bool IncludePatterns { get; set; }
+		
+		// Write the packed wave data of every instrument, base64 encoded.
+		public bool IncludeSamples { get; set; }
+		
+		// Songs exported at the same time by PsyBatchExporter, -1 for one per core.
+		public int MaxDegreeOfParallelism { get; set; }
+		
+		public PsyExportOptions ()
+		{
+			Format = PsyExportFormat.Json;
+			MaxDegreeOfParallelism = -1;
+		}
+		
+		public string FileExtension
+		{
+			get
+			{
+				switch (Format)
+				{
+				case PsyExportFormat.Json: return ".json";
+				case PsyExportFormat.Yaml: return ".yaml";
+				case PsyExportFormat.Xml: return ".xml";
+				default: return ".txt";
+				}
+			}
+		}
+		
+		// What PsyReader has to decode for these options.
+		public PsyReadOptions CreateReadOptions()
+		{
+			PsyReadOptions options = new PsyReadOptions();
+			if (!IncludePatterns) options.Chunks &= ~PsyChunkKinds.Patterns;
+			// Wave data is only read from the file if it is written out.
+			options.LazyWaves = !IncludeSamples;
+			return options;
+		}
+	}
+}
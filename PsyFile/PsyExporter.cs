@@ -0,0 +1,181 @@
+using System;
+using System.IO;
+using System.Text;
+
+namespace PsyFile
+{
+	// Writes a loaded song to a PsyDocumentWriter, or as text with PsyWriter.
+	public class PsyExporter
+	{
+		protected PsyExportOptions Options;
+		
+		public PsyExporter(PsyExportOptions options)
+		{
+			if (options == null) throw new ArgumentNullException("options");
+			
+			this.Options = options;
+		}
+		
+		// Loads a song and writes it to output. The song is only kept while it is written.
+		public void Export(string filePath, TextWriter output)
+		{
+			PsyFile psyfile = new PsyFile();
+			using (PsyReader reader = new PsyReader(filePath, psyfile, Options.CreateReadOptions()))
+			{
+				Export(psyfile, filePath, output);
+			}
+		}
+		
+		public void Export(PsyFile psyfile, string filePath, TextWriter output)
+		{
+			if (psyfile == null) throw new ArgumentNullException("psyfile");
+			if (output == null) throw new ArgumentNullException("output");
+			
+			if (Options.Format == PsyExportFormat.Text)
+			{
+				output.Write(new PsyWriter(psyfile).ToString());
+				output.Flush();
+				return;
+			}
+			
+			PsyDocumentWriter writer = CreateDocumentWriter(output);
+			writer.BeginDocument();
+			writer.WriteValue("file", filePath);
+			WriteSong(psyfile, writer);
+			writer.EndDocument();
+		}
+		
+		PsyDocumentWriter CreateDocumentWriter(TextWriter output)
+		{
+			switch (Options.Format)
+			{
+			case PsyExportFormat.Yaml: return new PsyYamlWriter(output);
+			case PsyExportFormat.Xml: return new PsyXmlWriter(output);
+			default: return new PsyJsonWriter(output);
+			}
+		}
+		
+		void WriteSong(PsyFile psyfile, PsyDocumentWriter writer)
+		{
+			writer.WriteValue("version", psyfile.ChunkVersion);
+			writer.WriteValue("title", psyfile.Title);
+			writer.WriteValue("artist", psyfile.Artist);
+			writer.WriteValue("comments", psyfile.Comments);
+			writer.WriteValue("tracks", psyfile.Tracks);
+			writer.WriteValue("bpm", psyfile.BeatsPerMinute);
+			writer.WriteValue("lpb", psyfile.LinesPerBeat);
+			
+			writer.BeginArray("sequence");
+			foreach (int index in psyfile.PlayOrder)
+			{
+				writer.WriteValue(null, index);
+			}
+			writer.EndArray();
+			
+			if (Options.IncludePatterns)
+			{
+				writer.BeginArray("patterns");
+				foreach (PsyPattern pattern in psyfile.Patterns)
+				{
+					if (pattern != null) WritePattern(pattern, writer);
+				}
+				writer.EndArray();
+			}
+			
+			writer.BeginArray("machines");
+			foreach (PsyMachine machine in psyfile.Machines)
+			{
+				if (machine != null) WriteMachine(machine, writer);
+			}
+			writer.EndArray();
+			
+			writer.BeginArray("instruments");
+			foreach (PsyInstrument instrument in psyfile.Instruments)
+			{
+				if (instrument != null) WriteInstrument(instrument, writer);
+			}
+			writer.EndArray();
+		}
+		
+		// Only the cells that are not blank.
+		void WritePattern(PsyPattern pattern, PsyDocumentWriter writer)
+		{
+			writer.BeginObject(null);
+			writer.WriteValue("index", pattern.Index);
+			writer.WriteValue("name", pattern.Name);
+			writer.WriteValue("lines", pattern.Lines);
+			writer.WriteValue("tracks", pattern.Tracks);
+			writer.BeginArray("events");
+			byte[] data = pattern.ReadOnlyData;
+			int tracks = pattern.Tracks;
+			// A pattern without lines has no tracks, whatever cells it was given.
+			int end = data == null || tracks == 0 ? 0 : data.Length;
+			for (int i = 0; i + PsyFile.EventSize <= end; i += PsyFile.EventSize)
+			{
+				if (data[i] == PsyPattern.EmptyNote && data[i + 1] == PsyPattern.EmptyInst && data[i + 2] == PsyPattern.EmptyMach
+					&& data[i + 3] == 0 && data[i + 4] == 0)
+				{
+					continue;
+				}
+				int cell = i / PsyFile.EventSize;
+				writer.BeginObject(null);
+				writer.WriteValue("line", cell / tracks);
+				writer.WriteValue("track", cell % tracks);
+				writer.WriteValue("note", data[i]);
+				writer.WriteValue("inst", data[i + 1]);
+				writer.WriteValue("mach", data[i + 2]);
+				writer.WriteValue("cmd", data[i + 3]);
+				writer.WriteValue("parameter", data[i + 4]);
+				writer.EndObject();
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+		
+		void WriteMachine(PsyMachine machine, PsyDocumentWriter writer)
+		{
+			writer.BeginObject(null);
+			writer.WriteValue("index", machine.Index);
+			writer.WriteValue("type", machine.Type);
+			writer.WriteValue("dllName", machine.DllName);
+			writer.WriteValue("editName", machine.EditName);
+			writer.WriteValue("bypass", machine.Bypass);
+			writer.WriteValue("mute", machine.Mute);
+			writer.BeginArray("outputs");
+			foreach (int output in machine.Outputs)
+			{
+				writer.WriteValue(null, output);
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+		
+		void WriteInstrument(PsyInstrument instrument, PsyDocumentWriter writer)
+		{
+			writer.BeginObject(null);
+			writer.WriteValue("index", instrument.Index);
+			writer.WriteValue("name", instrument.Name);
+			writer.WriteValue("panning", instrument.Panning);
+			writer.BeginArray("waves");
+			foreach (PsyWave wave in instrument.Waves)
+			{
+				writer.BeginObject(null);
+				writer.WriteValue("index", wave.Index);
+				writer.WriteValue("name", wave.Name);
+				writer.WriteValue("length", wave.Length);
+				writer.WriteValue("stereo", wave.Stereo);
+				writer.WriteValue("loop", wave.Loop);
+				writer.WriteValue("loopStart", wave.LoopStart);
+				writer.WriteValue("loopEnd", wave.LoopEnd);
+				if (Options.IncludeSamples)
+				{
+					writer.WriteValue("packedLeft", Convert.ToBase64String(wave.PackedLeft));
+					if (wave.Stereo) writer.WriteValue("packedRight", Convert.ToBase64String(wave.PackedRight));
+				}
+				writer.EndObject();
+			}
+			writer.EndArray();
+			writer.EndObject();
+		}
+	}
+}
@@ -1,9 +1,23 @@
 using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
 
 namespace PsyFile
 {
 	public class PsyFile
 	{
+		public const int MaxPatterns = 256;
+		public const int MaxInstruments = 256;
+		public const int MaxMachines = 256;
+		public const int MaxTracks = 64;
+		public const int EventSize = 5;
+		
+		// Strings in .psy files are plain 8-bit, null terminated.
+		public static readonly Encoding StringEncoding = Encoding.GetEncoding("iso-8859-1");
+
 		public string PsyVersion { get; set; }
 		public int ChunkVersion { get; set; }	
 		public int Size { get; set; }
@@ -14,9 +28,444 @@ namespace PsyFile
 		public string Artist { get; set; }
 		public string Comments { get; set; }
 		
+		// Song Properties
+		public int Tracks { get; set; }
+		public float BeatsPerMinute { get; set; }
+		public int LinesPerBeat { get; set; }
+		public int CurrentOctave { get; set; }
+		public int MachineSoloed { get; set; }
+		public int TrackSoloed { get; set; }
+		public int SeqBus { get; set; }
+		public int MidiSelected { get; set; }
+		public int AuxcolSelected { get; set; }
+		public int InstSelected { get; set; }
+		public int SequenceWidth { get; set; }
+		public bool[] TrackMuted { get; set; }
+		public bool[] TrackArmed { get; set; }
+		public bool ShareTrackNames { get; set; }
+		public string[] TrackNames { get; set; }
+		
+		// Sequence Data
+		public string SequenceName { get; set; }
+		// Assign a new array or use SetSequenceEntry, the usage index does not see
+		// writes into the array.
+		public int[] PlayOrder
+		{
+			get { return playOrder; }
+			set
+			{
+				playOrder = value ?? new int[0];
+				IndexSequence();
+			}
+		}
+		
+		int[] playOrder;
+		// Positions of each pattern in PlayOrder, in order, and the highest pattern in it.
+		List<int>[] sequencePositions = new List<int>[MaxPatterns];
+		int highestInSequence;
+		
+		// Chunk headers, in file order.
+		public List<PsyChunk> Chunks { get; set; }
+		
+		// Indexed by pattern number, null for the ones not in the file.
+		public PsyPattern[] Patterns { get; set; }
+		
+		// Indexed by instrument number, null for the ones not in the file.
+		public PsyInstrument[] Instruments { get; set; }
+		
+		// Indexed by machine number, null for the ones not in the file.
+		public PsyMachine[] Machines { get; set; }
 		
 		public PsyFile ()
 		{
+			Chunks = new List<PsyChunk>();
+			TrackMuted = new bool[0];
+			TrackArmed = new bool[0];
+			TrackNames = new string[0];
+			PlayOrder = new int[0];
+			Patterns = new PsyPattern[MaxPatterns];
+			Instruments = new PsyInstrument[MaxInstruments];
+			Machines = new PsyMachine[MaxMachines];
+		}
+		
+		public int PatternCount
+		{
+			get
+			{
+				int count = 0;
+				foreach (PsyPattern pattern in Patterns)
+				{
+					if (pattern != null) count++;
+				}
+				return count;
+			}
+		}
+		
+		// A blank pattern sized for the song's tracks, replacing any at index.
+		public PsyPattern CreatePattern(int index, int lines)
+		{
+			if (index < 0 || index >= MaxPatterns) throw new ArgumentOutOfRangeException("index");
+			
+			PsyPattern pattern = new PsyPattern(index, lines, Tracks);
+			Patterns[index] = pattern;
+			return pattern;
+		}
+		
+		// Adds a blank track at track to the song and to every pattern, which only
+		// ever hold cells for the song's tracks. Patterns saved narrower than the
+		// song, and empty ones, that end before track have nothing to move and are
+		// left as they are.
+		public void AddTrack(int track)
+		{
+			if (track < 0 || track > Tracks) throw new ArgumentOutOfRangeException("track");
+			if (Tracks >= MaxTracks) throw new InvalidOperationException("The song already has the most tracks allowed.");
+			
+			foreach (PsyPattern pattern in Patterns)
+			{
+				if (pattern == null || track > pattern.Tracks) continue;
+				
+				pattern.InsertTrack(track);
+				if (pattern.TrackNames != null) pattern.TrackNames = InsertTrack(pattern.TrackNames, track, "");
+			}
+			TrackMuted = InsertTrack(TrackMuted, track, false);
+			TrackArmed = InsertTrack(TrackArmed, track, false);
+			TrackNames = InsertTrack(TrackNames, track, "");
+			Tracks++;
+		}
+		
+		// Arrays that do not hold one entry per track, such as TrackNames when the
+		// names are not shared, are left as they are.
+		T[] InsertTrack<T>(T[] array, int index, T value)
+		{
+			if (array.Length != Tracks) return array;
+			
+			T[] result = new T[array.Length + 1];
+			Array.Copy(array, 0, result, 0, index);
+			result[index] = value;
+			Array.Copy(array, index, result, index + 1, array.Length - index);
+			return result;
+		}
+		
+		// Same rule as Song::IsPatternUsed: in the sequence, or with some data.
+		public bool IsPatternUsed(int index)
+		{
+			if (Patterns[index] == null) return false;
+			if (IsInSequence(index)) return true;
+			return !Patterns[index].IsEmpty();
+		}
+		
+		public bool IsInSequence(int index)
+		{
+			if (index < 0 || index >= MaxPatterns) return false;
+			return sequencePositions[index] != null && sequencePositions[index].Count > 0;
+		}
+		
+		// Where the pattern is played, in order.
+		public int[] GetSequencePositions(int index)
+		{
+			if (!IsInSequence(index)) return new int[0];
+			return sequencePositions[index].ToArray();
+		}
+		
+		// Zero for an empty sequence, as in Song::GetHighestPatternIndexInSequence.
+		public int GetHighestPatternIndexInSequence()
+		{
+			return highestInSequence;
+		}
+		
+		// Patterns with some data, as Song::GetNumPatterns counts them.
+		public int GetNumPatterns()
+		{
+			int count = 0;
+			foreach (PsyPattern pattern in Patterns)
+			{
+				if (pattern != null && !pattern.IsEmpty()) count++;
+			}
+			return count;
+		}
+		
+		// Same choice as Song::GetBlankPatternUnused: the first unused pattern, or
+		// else the search below, step for step.
+		public int GetBlankPatternUnused(int start)
+		{
+			for (int i = 0; i < MaxPatterns; i++)
+			{
+				if (!IsPatternUsed(i)) return i;
+			}
+			// From start, past the patterns in the sequence, to one that is blank. When
+			// that runs past the last pattern, the first one not in the sequence.
+			int index = Math.Max(0, start);
+			bool tryAgain = true;
+			while (tryAgain && index < MaxPatterns - 1)
+			{
+				while (IsInSequence(index)) index++;
+				tryAgain = false;
+				if (index < MaxPatterns - 1 && !Patterns[index].IsEmpty())
+				{
+					index++;
+					tryAgain = true;
+				}
+			}
+			if (index > MaxPatterns - 1)
+			{
+				index = 0;
+				while (IsInSequence(index)) index++;
+				if (index > MaxPatterns - 1) index = MaxPatterns - 1;
+			}
+			return index;
+		}
+		
+		// Plays pattern index at position, growing the sequence when position is
+		// just past its end.
+		public void SetSequenceEntry(int position, int index)
+		{
+			if (position < 0 || position > playOrder.Length) throw new ArgumentOutOfRangeException("position");
+			if (index < 0 || index >= MaxPatterns) throw new ArgumentOutOfRangeException("index");
+			
+			if (position == playOrder.Length)
+			{
+				int[] grown = new int[position + 1];
+				Array.Copy(playOrder, grown, position);
+				playOrder = grown;
+			}
+			else
+			{
+				int old = playOrder[position];
+				if (old == index) return;
+				
+				if (IsInSequence(old))
+				{
+					List<int> positions = sequencePositions[old];
+					positions.RemoveAt(positions.BinarySearch(position));
+					if (old == highestInSequence && positions.Count == 0) highestInSequence = FindHighestInSequence();
+				}
+			}
+			playOrder[position] = index;
+			AddSequencePosition(index, position);
+		}
+		
+		void IndexSequence()
+		{
+			foreach (List<int> positions in sequencePositions)
+			{
+				if (positions != null) positions.Clear();
+			}
+			highestInSequence = 0;
+			for (int position = 0; position < playOrder.Length; position++)
+			{
+				int index = playOrder[position];
+				// Out of range entries are kept in PlayOrder but are not patterns.
+				if (index >= 0 && index < MaxPatterns) AddSequencePosition(index, position);
+			}
+		}
+		
+		void AddSequencePosition(int index, int position)
+		{
+			List<int> positions = sequencePositions[index];
+			if (positions == null) positions = sequencePositions[index] = new List<int>();
+			int at = positions.BinarySearch(position);
+			positions.Insert(at < 0 ? ~at : at, position);
+			if (index > highestInSequence) highestInSequence = index;
+		}
+		
+		int FindHighestInSequence()
+		{
+			for (int i = MaxPatterns - 1; i > 0; i--)
+			{
+				if (IsInSequence(i)) return i;
+			}
+			return 0;
+		}
+		
+		// Finds patterns with the same cells and makes them share one copy, until
+		// one of them is edited. Sparse patterns are left alone, column patterns that
+		// have a copy are kept row by row. Returns the number of patterns that now
+		// share the cells of another.
+		public int SharePatterns()
+		{
+			Dictionary<byte[], PsyPattern> unique = new Dictionary<byte[], PsyPattern>(PsyCellsComparer.Default);
+			int shared = 0;
+			foreach (PsyPattern pattern in Patterns)
+			{
+				if (pattern == null || pattern.Sparse != null) continue;
+				
+				byte[] cells = pattern.ReadOnlyData;
+				if (cells == null) continue;
+				
+				PsyPattern first;
+				if (!unique.TryGetValue(cells, out first))
+				{
+					unique.Add(cells, pattern);
+				}
+				else if (!pattern.SharesCellsWith(first))
+				{
+					pattern.ShareCells(first);
+					shared++;
+				}
+			}
+			return shared;
+		}
+		
+		// Decompresses every pattern still kept packed, in index order.
+		public Task PrefetchPatterns()
+		{
+			return PrefetchPatterns(CancellationToken.None);
+		}
+		
+		// Stops between patterns once token is cancelled.
+		public Task PrefetchPatterns(CancellationToken token)
+		{
+			PsyPattern[] patterns = (PsyPattern[])Patterns.Clone();
+			return Task.Factory.StartNew(() =>
+			{
+				foreach (PsyPattern pattern in patterns)
+				{
+					if (token.IsCancellationRequested) return;
+					if (pattern == null || pattern.IsUnpacked) continue;
+					try
+					{
+						pattern.Decompress();
+					}
+					catch (InvalidDataException)
+					{
+						// Left packed, the error shows up again when the pattern is used.
+					}
+				}
+			});
+		}
+		
+		public int InstrumentCount
+		{
+			get
+			{
+				int count = 0;
+				foreach (PsyInstrument instrument in Instruments)
+				{
+					if (instrument != null) count++;
+				}
+				return count;
+			}
+		}
+		
+		// Instruments used by the aux column of the patterns in the sequence, each
+		// pattern looked at once however often it is played. Packed patterns are
+		// read from a copy and stay packed.
+		public bool[] GetUsedInstruments()
+		{
+			bool[] used = new bool[MaxInstruments];
+			for (int index = 0; index < MaxPatterns; index++)
+			{
+				PsyPattern pattern = Patterns[index];
+				if (pattern == null || !IsInSequence(index)) continue;
+				
+				PsySparseCells sparse = pattern.Sparse;
+				if (sparse != null)
+				{
+					for (int i = 0; i < sparse.Count; i++)
+					{
+						byte inst = sparse.GetField(i, 1);
+						if (inst != 255) used[inst] = true;
+					}
+					continue;
+				}
+				
+				PsyPatternColumns columns = pattern.Columns;
+				if (columns != null)
+				{
+					foreach (byte inst in columns.Instruments)
+					{
+						if (inst != 255) used[inst] = true;
+					}
+					continue;
+				}
+				
+				byte[] data = pattern.ReadOnlyData;
+				if (data == null) continue;
+				for (int i = 1; i < data.Length; i += EventSize)
+				{
+					if (data[i] != 255) used[data[i]] = true;
+				}
+			}
+			return used;
+		}
+		
+		// Reads the packed wave data still left in the file for the used instruments.
+		public Task PrefetchWaves()
+		{
+			return PrefetchWaves(CancellationToken.None);
+		}
+		
+		// Stops between waves once token is cancelled.
+		public Task PrefetchWaves(CancellationToken token)
+		{
+			PsyInstrument[] instruments = (PsyInstrument[])Instruments.Clone();
+			return Task.Factory.StartNew(() =>
+			{
+				bool[] used;
+				try
+				{
+					used = GetUsedInstruments();
+				}
+				catch (InvalidDataException)
+				{
+					return;
+				}
+				for (int i = 0; i < instruments.Length; i++)
+				{
+					if (!used[i] || instruments[i] == null) continue;
+					foreach (PsyWave wave in instruments[i].Waves)
+					{
+						if (token.IsCancellationRequested) return;
+						try
+						{
+							wave.Load();
+						}
+						catch (IOException)
+						{
+							// Left in the file, the error shows up again when the wave is used.
+						}
+						catch (ObjectDisposedException)
+						{
+							return;
+						}
+					}
+				}
+			});
+		}
+		
+		// A consistent copy of the song to save while this one keeps being edited.
+		// Only references are copied: pattern cells are copied when they are next
+		// edited, wave and raw chunk data are never written into.
+		public PsyFile Snapshot()
+		{
+			PsyFile copy = (PsyFile)MemberwiseClone();
+			copy.TrackMuted = (bool[])TrackMuted.Clone();
+			copy.TrackArmed = (bool[])TrackArmed.Clone();
+			copy.TrackNames = (string[])TrackNames.Clone();
+			// Its own usage index, which setting PlayOrder builds along with the highest pattern.
+			copy.sequencePositions = new List<int>[MaxPatterns];
+			copy.PlayOrder = (int[])PlayOrder.Clone();
+			copy.Chunks = new List<PsyChunk>(Chunks.Count);
+			foreach (PsyChunk chunk in Chunks)
+			{
+				copy.Chunks.Add(chunk.Snapshot());
+			}
+			copy.Patterns = new PsyPattern[Patterns.Length];
+			for (int i = 0; i < Patterns.Length; i++)
+			{
+				if (Patterns[i] != null) copy.Patterns[i] = Patterns[i].Snapshot();
+			}
+			copy.Instruments = new PsyInstrument[Instruments.Length];
+			for (int i = 0; i < Instruments.Length; i++)
+			{
+				if (Instruments[i] != null) copy.Instruments[i] = Instruments[i].Snapshot();
+			}
+			copy.Machines = new PsyMachine[Machines.Length];
+			for (int i = 0; i < Machines.Length; i++)
+			{
+				if (Machines[i] != null) copy.Machines[i] = Machines[i].Snapshot();
+			}
+			return copy;
 		}
 		
 		public override string ToString ()
@@ -0,0 +1,186 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+
+namespace PsyFile
+{
+	// Reads a stream that cannot seek, such as a pipe or standard input. Moving
+	// forward reads and drops the bytes in between. Moving back only works for
+	// the last RewindLimit bytes, which is all PsyReader needs in a single pass.
+	public class PsyForwardFile : PsyRiffFile
+	{
+		// Covers the longest INFO chunk, whose strings are read twice.
+		public const int RewindLimit = 1 << 17;
+		
+		protected Stream Stream;
+		byte[] buffer = new byte[1 << 16];
+		long bufferStart;
+		int filled;
+		long position;
+		
+		public PsyForwardFile(Stream stream)
+		{
+			if (stream == null) throw new ArgumentNullException("stream");
+			
+			this.Stream = stream;
+		}
+		
+		public override bool CanSeek
+		{
+			get { return false; }
+		}
+		
+		public override long Position
+		{
+			get { return position; }
+			set
+			{
+				if (value < bufferStart) throw new NotSupportedException("Cannot move back that far in a stream that cannot seek.");
+				position = value;
+			}
+		}
+		
+		public override long Length
+		{
+			get { throw new NotSupportedException("The length of a stream that cannot seek is not known."); }
+		}
+		
+		public override bool IsAvailable(long count)
+		{
+			return Fill(count);
+		}
+		
+		// Makes count bytes from position available in the buffer, false when the
+		// stream ends first.
+		bool Fill(long count)
+		{
+			long end = position + count;
+			if (end <= bufferStart + filled) return true;
+			
+			// Drop what is too far behind position to be moved back to.
+			long keep = position - RewindLimit;
+			if (keep > bufferStart)
+			{
+				long bufferEnd = bufferStart + filled;
+				if (keep >= bufferEnd)
+				{
+					bufferStart = bufferEnd;
+					filled = 0;
+				}
+				else
+				{
+					int drop = (int)(keep - bufferStart);
+					Buffer.BlockCopy(buffer, drop, buffer, 0, filled - drop);
+					filled -= drop;
+					bufferStart = keep;
+				}
+				while (bufferStart < keep)
+				{
+					int skipped = Stream.Read(buffer, 0, (int)Math.Min(buffer.Length, keep - bufferStart));
+					if (skipped == 0) return false;
+					bufferStart += skipped;
+				}
+			}
+			
+			long needed = end - bufferStart;
+			if (needed > buffer.Length)
+			{
+				byte[] grown = new byte[Math.Max(needed, 2L * buffer.Length)];
+				Buffer.BlockCopy(buffer, 0, grown, 0, filled);
+				buffer = grown;
+			}
+			while (filled < needed)
+			{
+				int read = Stream.Read(buffer, filled, buffer.Length - filled);
+				if (read == 0) return false;
+				filled += read;
+			}
+			return true;
+		}
+		
+		public override byte[] Peek(int count)
+		{
+			Fill(count);
+			int available = (int)Math.Max(0, Math.Min(count, bufferStart + filled - position));
+			byte[] bytes = new byte[available];
+			if (available > 0) Buffer.BlockCopy(buffer, (int)(position - bufferStart), bytes, 0, available);
+			return bytes;
+		}
+		
+		// Index in the buffer of count bytes at position, which then moves past them.
+		int Take(int count)
+		{
+			if (!Fill(count)) throw new EndOfStreamException();
+			int index = (int)(position - bufferStart);
+			position += count;
+			return index;
+		}
+		
+		public override byte ReadByte()
+		{
+			int i = Take(1);
+			return buffer[i];
+		}
+		
+		public override short ReadInt16()
+		{
+			int i = Take(2);
+			return (short)(buffer[i] | (buffer[i + 1] << 8));
+		}
+		
+		public override int ReadInt32()
+		{
+			int i = Take(4);
+			return buffer[i] | (buffer[i + 1] << 8) | (buffer[i + 2] << 16) | (buffer[i + 3] << 24);
+		}
+		
+		public override byte[] ReadBytes(int count)
+		{
+			if (count < 0) throw new ArgumentOutOfRangeException("count");
+			
+			byte[] bytes = new byte[count];
+			int index = Take(count); // Can replace the buffer.
+			Buffer.BlockCopy(buffer, index, bytes, 0, count);
+			return bytes;
+		}
+		
+		public override string ReadId(int length)
+		{
+			return PsyFile.StringEncoding.GetString(ReadBytes(length));
+		}
+		
+		public override string ReadString(int maxLength)
+		{
+			List<byte> bytes = new List<byte>();
+			byte b;
+			while ((b = ReadByte()) != 0)
+			{
+				if (bytes.Count < maxLength) bytes.Add(b);
+			}
+			return PsyFile.StringEncoding.GetString(bytes.ToArray());
+		}
+		
+		// Only for bytes still in the buffer. Unlike the seekable files, this is not
+		// meant to be called from other threads while reading.
+		public override byte[] ReadBytesAt(long offset, int count)
+		{
+			if (offset < bufferStart || offset + count > bufferStart + filled)
+			{
+				throw new NotSupportedException("The bytes are no longer buffered in a stream that cannot seek.");
+			}
+			byte[] bytes = new byte[count];
+			Buffer.BlockCopy(buffer, (int)(offset - bufferStart), bytes, 0, count);
+			return bytes;
+		}
+		
+		public override byte[] DecompressZ77(long offset, int size)
+		{
+			return BeerZ77.Decompress(ReadBytesAt(offset, size));
+		}
+		
+		protected override void Dispose(bool disposing)
+		{
+			if (disposing) Stream.Close();
+		}
+	}
+}
@@ -0,0 +1,63 @@
+using System;
+using System.Collections.Generic;
+
+namespace PsyFile
+{
+	// Sampler instrument, from an INSD chunk.
+	public class PsyInstrument
+	{
+		public int Index { get; set; }
+		public string Name { get; set; }
+		public bool Loop { get; set; }
+		public int Lines { get; set; }
+		public int NNA { get; set; }
+		
+		// Amplitude envelope, in samples. Sustain 0..100.
+		public int EnvAttack { get; set; }
+		public int EnvDecay { get; set; }
+		public int EnvSustain { get; set; }
+		public int EnvRelease { get; set; }
+		
+		// Filter envelope, in samples. Sustain 0..128.
+		public int FilterEnvAttack { get; set; }
+		public int FilterEnvDecay { get; set; }
+		public int FilterEnvSustain { get; set; }
+		public int FilterEnvRelease { get; set; }
+		public int FilterCutoff { get; set; }
+		public int FilterResonance { get; set; }
+		public int FilterAmount { get; set; }
+		public int FilterType { get; set; }
+		
+		public int Panning { get; set; }
+		public bool RandomPan { get; set; }
+		public bool RandomCutoff { get; set; }
+		public bool RandomResonance { get; set; }
+		
+		// Since INSD version 1.
+		public int LockInstrument { get; set; }
+		public bool UseLock { get; set; }
+		
+		public List<PsyWave> Waves { get; set; }
+		
+		public PsyInstrument ()
+		{
+			Waves = new List<PsyWave>();
+		}
+		
+		public PsyInstrument Snapshot()
+		{
+			PsyInstrument copy = (PsyInstrument)MemberwiseClone();
+			copy.Waves = new List<PsyWave>(Waves.Count);
+			foreach (PsyWave wave in Waves)
+			{
+				copy.Waves.Add(wave.Snapshot());
+			}
+			return copy;
+		}
+		
+		public override string ToString ()
+		{
+			return string.Format ("[PsyInstrument: Index={0}, Name={1}, Waves={2}]", Index, Name, Waves.Count);
+		}
+	}
+}
@@ -0,0 +1,143 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Text;
+
+namespace PsyFile
+{
+	public class PsyJsonWriter : PsyDocumentWriter
+	{
+		// One entry per open object or array: true until its first member is written.
+		readonly Stack<bool> first = new Stack<bool>();
+		readonly Stack<bool> inArray = new Stack<bool>();
+		
+		public PsyJsonWriter(TextWriter output)
+			: base(output)
+		{
+		}
+		
+		public override void BeginDocument()
+		{
+			Output.Write('{');
+			first.Push(true);
+			inArray.Push(false);
+		}
+		
+		public override void EndDocument()
+		{
+			EndObject();
+			Output.WriteLine();
+			Output.Flush();
+		}
+		
+		public override void BeginObject(string name)
+		{
+			WriteName(name);
+			Output.Write('{');
+			first.Push(true);
+			inArray.Push(false);
+		}
+		
+		public override void EndObject()
+		{
+			first.Pop();
+			inArray.Pop();
+			Output.Write('}');
+		}
+		
+		public override void BeginArray(string name)
+		{
+			WriteName(name);
+			Output.Write('[');
+			first.Push(true);
+			inArray.Push(true);
+		}
+		
+		public override void EndArray()
+		{
+			first.Pop();
+			inArray.Pop();
+			Output.Write(']');
+		}
+		
+		public override void WriteValue(string name, string value)
+		{
+			WriteName(name);
+			if (value == null)
+			{
+				Output.Write("null");
+			}
+			else
+			{
+				WriteString(value);
+			}
+		}
+		
+		public override void WriteValue(string name, long value)
+		{
+			WriteName(name);
+			Output.Write(value.ToString(CultureInfo.InvariantCulture));
+		}
+		
+		public override void WriteValue(string name, double value)
+		{
+			WriteName(name);
+			// JSON has no NaN or infinity.
+			if (Double.IsNaN(value) || Double.IsInfinity(value))
+			{
+				Output.Write("null");
+			}
+			else
+			{
+				Output.Write(value.ToString("R", CultureInfo.InvariantCulture));
+			}
+		}
+		
+		public override void WriteValue(string name, bool value)
+		{
+			WriteName(name);
+			Output.Write(value ? "true" : "false");
+		}
+		
+		void WriteName(string name)
+		{
+			if (!first.Pop()) Output.Write(',');
+			first.Push(false);
+			if (!inArray.Peek())
+			{
+				WriteString(name);
+				Output.Write(':');
+			}
+		}
+		
+		void WriteString(string value)
+		{
+			StringBuilder builder = new StringBuilder(value.Length + 2);
+			builder.Append('"');
+			foreach (char c in value)
+			{
+				switch (c)
+				{
+				case '"': builder.Append("\\\""); break;
+				case '\\': builder.Append("\\\\"); break;
+				case '\n': builder.Append("\\n"); break;
+				case '\r': builder.Append("\\r"); break;
+				case '\t': builder.Append("\\t"); break;
+				default:
+					if (c < ' ')
+					{
+						builder.AppendFormat("\\u{0:x4}", (int)c);
+					}
+					else
+					{
+						builder.Append(c);
+					}
+					break;
+				}
+			}
+			builder.Append('"');
+			Output.Write(builder.ToString());
+		}
+	}
+}
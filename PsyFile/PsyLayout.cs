@@ -0,0 +1,51 @@
+using System;
+using System.Collections.Generic;
+
+namespace PsyFile
+{
+	// A fixed run of little endian ints in a chunk, listed once for both the
+	// reader and the writer. The whole run is decoded from, or encoded into,
+	// one block of bytes.
+	public class PsyLayout<T>
+	{
+		readonly List<Func<T, int>> getters = new List<Func<T, int>>();
+		readonly List<Action<T, int>> setters = new List<Action<T, int>>();
+		
+		public PsyLayout<T> Int32(Func<T, int> get, Action<T, int> set)
+		{
+			getters.Add(get);
+			setters.Add(set);
+			return this;
+		}
+		
+		public int Size
+		{
+			get { return getters.Count * sizeof(int); }
+		}
+		
+		public void Decode(byte[] data, T target)
+		{
+			if (data == null) throw new ArgumentNullException("data");
+			if (data.Length < Size) throw new ArgumentException("Not enough data for the layout.", "data");
+			
+			for (int i = 0, o = 0; i < setters.Count; i++, o += sizeof(int))
+			{
+				setters[i](target, data[o] | (data[o + 1] << 8) | (data[o + 2] << 16) | (data[o + 3] << 24));
+			}
+		}
+		
+		public byte[] Encode(T source)
+		{
+			byte[] data = new byte[Size];
+			for (int i = 0, o = 0; i < getters.Count; i++, o += sizeof(int))
+			{
+				int value = getters[i](source);
+				data[o] = (byte)value;
+				data[o + 1] = (byte)(value >> 8);
+				data[o + 2] = (byte)(value >> 16);
+				data[o + 3] = (byte)(value >> 24);
+			}
+			return data;
+		}
+	}
+}
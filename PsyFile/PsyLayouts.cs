@@ -0,0 +1,86 @@
+using System;
+
+namespace PsyFile
+{
+	// Layouts of the fixed parts of the song chunks, and block conversions for
+	// the arrays that follow them.
+	public static class PsyLayouts
+	{
+		// SNGI, up to the per track flags.
+		public static readonly PsyLayout<PsyFile> SongProperties = new PsyLayout<PsyFile>()
+			.Int32(f => f.Tracks, (f, v) => f.Tracks = v)
+			// Decimal BPM: the int is split in the integer part and the hundredths.
+			.Int32(f => PackBeatsPerMinute(f.BeatsPerMinute), (f, v) => f.BeatsPerMinute = (short)v + (short)(v >> 16) / 100.0f)
+			.Int32(f => f.LinesPerBeat, (f, v) => f.LinesPerBeat = v)
+			.Int32(f => f.CurrentOctave, (f, v) => f.CurrentOctave = v)
+			.Int32(f => f.MachineSoloed, (f, v) => f.MachineSoloed = v)
+			.Int32(f => f.TrackSoloed, (f, v) => f.TrackSoloed = v)
+			.Int32(f => f.SeqBus, (f, v) => f.SeqBus = v)
+			.Int32(f => f.MidiSelected, (f, v) => f.MidiSelected = v)
+			.Int32(f => f.AuxcolSelected, (f, v) => f.AuxcolSelected = v)
+			.Int32(f => f.InstSelected, (f, v) => f.InstSelected = v)
+			// Always saved as 1, the only width psycle supports.
+			.Int32(f => 1, (f, v) => f.SequenceWidth = v);
+		
+		static int PackBeatsPerMinute(float bpm)
+		{
+			int coarse = (int)bpm;
+			int fine = (int)Math.Round((bpm - coarse) * 100);
+			return (ushort)coarse | (fine << 16);
+		}
+		
+		public static int[] DecodeInt32s(byte[] data)
+		{
+			int[] values = new int[data.Length / sizeof(int)];
+			if (BitConverter.IsLittleEndian)
+			{
+				Buffer.BlockCopy(data, 0, values, 0, values.Length * sizeof(int));
+				return values;
+			}
+			for (int i = 0, o = 0; i < values.Length; i++, o += sizeof(int))
+			{
+				values[i] = data[o] | (data[o + 1] << 8) | (data[o + 2] << 16) | (data[o + 3] << 24);
+			}
+			return values;
+		}
+		
+		public static byte[] EncodeInt32s(int[] values)
+		{
+			byte[] data = new byte[values.Length * sizeof(int)];
+			if (BitConverter.IsLittleEndian)
+			{
+				Buffer.BlockCopy(values, 0, data, 0, data.Length);
+				return data;
+			}
+			for (int i = 0, o = 0; i < values.Length; i++, o += sizeof(int))
+			{
+				data[o] = (byte)values[i];
+				data[o + 1] = (byte)(values[i] >> 8);
+				data[o + 2] = (byte)(values[i] >> 16);
+				data[o + 3] = (byte)(values[i] >> 24);
+			}
+			return data;
+		}
+		
+		// The muted and armed flag of each track, one pair after the other.
+		public static void DecodeTrackFlags(byte[] data, bool[] muted, bool[] armed)
+		{
+			for (int t = 0; t < muted.Length; t++)
+			{
+				muted[t] = data[2 * t] != 0;
+				armed[t] = data[2 * t + 1] != 0;
+			}
+		}
+		
+		public static byte[] EncodeTrackFlags(int tracks, bool[] muted, bool[] armed)
+		{
+			byte[] data = new byte[2 * tracks];
+			for (int t = 0; t < tracks; t++)
+			{
+				data[2 * t] = (byte)(t < muted.Length && muted[t] ? 1 : 0);
+				data[2 * t + 1] = (byte)(t < armed.Length && armed[t] ? 1 : 0);
+			}
+			return data;
+		}
+	}
+}
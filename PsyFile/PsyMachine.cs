@@ -0,0 +1,45 @@
+using System;
+using System.Collections.Generic;
+
+namespace PsyFile
+{
+	// The common part of a MACD chunk. The machine specific data is not decoded,
+	// the whole chunk body stays in PsyChunk.Data.
+	public class PsyMachine
+	{
+		public const int MaxConnections = 12;
+		
+		public int Index { get; set; }
+		public int Type { get; set; }
+		public string DllName { get; set; }
+		public bool Bypass { get; set; }
+		public bool Mute { get; set; }
+		public int Pan { get; set; }
+		public int X { get; set; }
+		public int Y { get; set; }
+		public string EditName { get; set; }
+		
+		// Machines connected to the input and output wires.
+		public List<int> Inputs { get; set; }
+		public List<int> Outputs { get; set; }
+		
+		public PsyMachine ()
+		{
+			Inputs = new List<int>();
+			Outputs = new List<int>();
+		}
+		
+		public PsyMachine Snapshot()
+		{
+			PsyMachine copy = (PsyMachine)MemberwiseClone();
+			copy.Inputs = new List<int>(Inputs);
+			copy.Outputs = new List<int>(Outputs);
+			return copy;
+		}
+		
+		public override string ToString ()
+		{
+			return string.Format ("[PsyMachine: Index={0}, Type={1}, DllName={2}, EditName={3}]", Index, Type, DllName, EditName);
+		}
+	}
+}
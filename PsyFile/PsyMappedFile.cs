@@ -0,0 +1,153 @@
+using System;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Runtime.InteropServices;
+
+namespace PsyFile
+{
+	// Read-only memory mapped .psy file. Values, strings and z77 data are decoded
+	// straight from the mapped pages, without copying them into buffers first.
+	public unsafe class PsyMappedFile : PsyRiffFile
+	{
+		MemoryMappedFile map;
+		MemoryMappedViewAccessor view;
+		byte* data;
+		long length;
+		long position;
+		
+		public PsyMappedFile(string filePath)
+		{
+			if (String.IsNullOrEmpty(filePath)) throw new ArgumentNullException("filePath");
+			
+			length = new FileInfo(filePath).Length;
+			if (length == 0) return; // Empty files cannot be mapped, every read will hit the end.
+			
+			map = MemoryMappedFile.CreateFromFile(filePath, FileMode.Open, null, 0, MemoryMappedFileAccess.Read);
+			view = map.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
+			view.SafeMemoryMappedViewHandle.AcquirePointer(ref data);
+		}
+		
+		public override long Position
+		{
+			get { return position; }
+			set { position = value; }
+		}
+		
+		public override long Length
+		{
+			get { return length; }
+		}
+		
+		// Pointer to count bytes at offset, or an exception when they are past the end.
+		byte* At(long offset, long count)
+		{
+			if (data == null && length > 0) throw new ObjectDisposedException("PsyMappedFile");
+			if (offset < 0 || count < 0 || offset + count > length) throw new EndOfStreamException();
+			return data + offset;
+		}
+		
+		public override byte ReadByte()
+		{
+			byte value = *At(position, 1);
+			position++;
+			return value;
+		}
+		
+		public override short ReadInt16()
+		{
+			byte* p = At(position, 2);
+			position += 2;
+			return (short)(p[0] | (p[1] << 8));
+		}
+		
+		public override int ReadInt32()
+		{
+			byte* p = At(position, 4);
+			position += 4;
+			return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+		}
+		
+		public override byte[] ReadBytes(int count)
+		{
+			byte[] bytes = ReadBytesAt(position, count);
+			position += count;
+			return bytes;
+		}
+		
+		// Lazy waves are read from other threads, which may still be copying when
+		// the file is disposed. The view's handle is held for the copy, so the
+		// pages stay mapped until it is done.
+		public override byte[] ReadBytesAt(long offset, int count)
+		{
+			byte[] bytes = new byte[count];
+			MemoryMappedViewAccessor view = this.view;
+			if (view == null)
+			{
+				At(offset, count);
+				return bytes;
+			}
+			
+			byte* p = null;
+			view.SafeMemoryMappedViewHandle.AcquirePointer(ref p);
+			try
+			{
+				if (offset < 0 || count < 0 || offset + count > length) throw new EndOfStreamException();
+				Marshal.Copy((IntPtr)(p + offset), bytes, 0, count);
+			}
+			finally
+			{
+				view.SafeMemoryMappedViewHandle.ReleasePointer();
+			}
+			return bytes;
+		}
+		
+		public override string ReadId(int length)
+		{
+			byte* p = At(position, length);
+			position += length;
+			return new string((sbyte*)p, 0, length, PsyFile.StringEncoding);
+		}
+		
+		public override string ReadString(int maxLength)
+		{
+			byte* p = At(position, 0);
+			long count = 0;
+			while (position + count < length && p[count] != 0) count++;
+			// Skip past the terminator, if the file has one.
+			position += Math.Min(count + 1, length - position);
+			return new string((sbyte*)p, 0, (int)Math.Min(count, maxLength), PsyFile.StringEncoding);
+		}
+		
+		public override byte[] DecompressZ77(long offset, int size)
+		{
+			MemoryMappedViewAccessor view = this.view;
+			if (view == null) return BeerZ77.Decompress(At(offset, size), size);
+			
+			byte* p = null;
+			view.SafeMemoryMappedViewHandle.AcquirePointer(ref p);
+			try
+			{
+				if (offset < 0 || size < 0 || offset + size > length) throw new EndOfStreamException();
+				return BeerZ77.Decompress(p + offset, size);
+			}
+			finally
+			{
+				view.SafeMemoryMappedViewHandle.ReleasePointer();
+			}
+		}
+		
+		protected override void Dispose(bool disposing)
+		{
+			if (!disposing || view == null) return;
+			
+			if (data != null)
+			{
+				view.SafeMemoryMappedViewHandle.ReleasePointer();
+				data = null;
+			}
+			view.Dispose();
+			map.Dispose();
+			view = null;
+		}
+	}
+}
@@ -0,0 +1,629 @@
+using System;
+using System.Threading;
+
+namespace PsyFile
+{
+	public class PsyPattern
+	{
+		// A blank PatternEntry: no note, no aux, no machine, no command.
+		public const byte EmptyNote = 255;
+		public const byte EmptyInst = 255;
+		public const byte EmptyMach = 255;
+		static readonly byte[] BlankCell = { EmptyNote, EmptyInst, EmptyMach, 0, 0 };
+		
+		// A sparse cell takes nine bytes instead of five, and its scans go event by
+		// event, so only patterns with at most one cell in four used are worth it.
+		public const int SparseCellRatio = 4;
+		
+		int index;
+		int lines;
+		string name;
+		string[] trackNames;
+		byte[] data;
+		byte[] packed;
+		PsySparseCells sparse;
+		PsyPatternColumns columns;
+		int revision;
+		// Cells that are not blank, counted at usedCellsRevision.
+		int usedCells;
+		int usedCellsRevision = -1;
+		// Set while data is also referenced by a snapshot, copied before it can be written.
+		bool shared;
+		readonly object sync = new object();
+
+		public PsyPattern ()
+		{
+			EncodedChunk = new PsyChunkCache();
+		}
+		
+		// A blank pattern, with cells for exactly lines x tracks.
+		public PsyPattern (int index, int lines, int tracks)
+			: this()
+		{
+			if (lines < 0) throw new ArgumentOutOfRangeException("lines");
+			if (tracks < 0) throw new ArgumentOutOfRangeException("tracks");
+			
+			this.index = index;
+			this.lines = lines;
+			data = new byte[lines * tracks * PsyFile.EventSize];
+			FillBlank(data, 0, data.Length);
+		}
+		
+		public int Index
+		{
+			get { return index; }
+			set { index = value; MarkDirty(); }
+		}
+		
+		public int Lines
+		{
+			get { return lines; }
+			set { lines = value; MarkDirty(); }
+		}
+		
+		public string Name
+		{
+			get { return name; }
+			set { name = value; MarkDirty(); }
+		}
+		
+		// Only stored when the song does not share its track names.
+		public string[] TrackNames
+		{
+			get { return trackNames; }
+			set { trackNames = value; MarkDirty(); }
+		}
+		
+		// Changes with every edit. The setters and SetEvent update it, code that
+		// writes into Data directly has to call MarkDirty.
+		public int Revision
+		{
+			get { return Thread.VolatileRead(ref revision); }
+		}
+		
+		// The PATD chunk PsyBinaryWriter last encoded for this pattern.
+		public PsyChunkCache EncodedChunk { get; private set; }
+		
+		public void MarkDirty()
+		{
+			Interlocked.Increment(ref revision);
+		}
+
+		// Uncompressed PatternEntry cells (note, inst, mach, cmd, parameter),
+		// one line after the other. Decompressed from Packed, or expanded from
+		// Sparse, the first time it is used. Getting it marks the pattern dirty,
+		// since the cells can be written through the array.
+		public byte[] Data
+		{
+			get
+			{
+				byte[] cells;
+				lock (sync)
+				{
+					Unpack();
+					if (shared)
+					{
+						data = (byte[])data.Clone();
+						shared = false;
+					}
+					cells = data;
+				}
+				MarkDirty();
+				return cells;
+			}
+			set
+			{
+				lock (sync)
+				{
+					data = value;
+					packed = null;
+					sparse = null;
+					columns = null;
+					shared = false;
+				}
+				MarkDirty();
+			}
+		}
+		
+		// Same cells as Data, for code that only reads them. Cells shared with a
+		// snapshot are not copied, and packed, sparse or column cells stay as they
+		// are: the dense copy returned is not kept.
+		internal byte[] ReadOnlyData
+		{
+			get
+			{
+				lock (sync)
+				{
+					if (data != null) return data;
+					if (packed != null) return BeerZ77.Decompress(packed);
+					if (sparse != null) return sparse.ToDense();
+					if (columns != null) return columns.ToCells();
+					return null;
+				}
+			}
+		}
+		
+		// Decompresses Packed now rather than when Data is first used.
+		internal void Decompress()
+		{
+			lock (sync)
+			{
+				if (packed != null) Unpack();
+			}
+		}
+		
+		void Unpack()
+		{
+			if (data == null && packed != null)
+			{
+				data = BeerZ77.Decompress(packed);
+				packed = null;
+			}
+			else if (data == null && sparse != null)
+			{
+				data = sparse.ToDense();
+				sparse = null;
+			}
+			else if (data == null && columns != null)
+			{
+				data = columns.ToCells();
+				columns = null;
+			}
+		}
+		
+		// The cells that are not blank, while the pattern is kept sparse. Null once
+		// Data has been asked for.
+		public PsySparseCells Sparse
+		{
+			get
+			{
+				lock (sync)
+				{
+					return sparse;
+				}
+			}
+		}
+		
+		// Keeps only the cells that are not blank. SetEvent, IsEmpty and saving work
+		// on them as they are, anything that uses Data makes the pattern dense again.
+		public void Compact()
+		{
+			lock (sync)
+			{
+				if (sparse != null) return;
+				Unpack();
+				if (data == null) return;
+				
+				sparse = PsySparseCells.FromDense(data);
+				data = null;
+				shared = false;
+			}
+		}
+		
+		// The cells split by track and field, while the pattern is kept in columns.
+		// Null once Data has been asked for. Code that writes into it has to call
+		// MarkDirty, as with Data.
+		public PsyPatternColumns Columns
+		{
+			get
+			{
+				lock (sync)
+				{
+					return columns;
+				}
+			}
+		}
+		
+		// Keeps the cells in columns. SetEvent and InsertTrack work on them as they
+		// are, so adding a track is a few block copies per field instead of one per
+		// line. Anything that uses Data makes the pattern row by row again.
+		public void UseColumns()
+		{
+			lock (sync)
+			{
+				if (columns != null) return;
+				Unpack();
+				if (data == null) return;
+				
+				columns = PsyPatternColumns.FromCells(data, lines, Tracks);
+				data = null;
+				shared = false;
+			}
+		}
+		
+		// z77 data as found in the PATD chunk, kept until Data is first used.
+		public byte[] Packed
+		{
+			get
+			{
+				lock (sync)
+				{
+					return packed;
+				}
+			}
+			set
+			{
+				lock (sync)
+				{
+					packed = value;
+					data = null;
+					sparse = null;
+					columns = null;
+					shared = false;
+				}
+				MarkDirty();
+			}
+		}
+		
+		public bool IsUnpacked
+		{
+			get
+			{
+				lock (sync)
+				{
+					return packed == null;
+				}
+			}
+		}
+
+		public int Tracks
+		{
+			get
+			{
+				if (Lines == 0) return 0;
+				return UnpackedSize / (Lines * PsyFile.EventSize);
+			}
+		}
+		
+		// Known without decompressing, z77 data starts with the unpacked size.
+		int UnpackedSize
+		{
+			get
+			{
+				lock (sync)
+				{
+					if (data != null) return data.Length;
+					if (sparse != null) return sparse.Size;
+					if (columns != null) return columns.Lines * columns.Tracks * PsyFile.EventSize;
+					if (packed != null && packed.Length >= 4)
+					{
+						return packed[0] | (packed[1] << 8) | (packed[2] << 16) | (packed[3] << 24);
+					}
+					return 0;
+				}
+			}
+		}
+
+		// Keeps the cells that still fit, the new ones are blank.
+		public void Resize(int lines, int tracks)
+		{
+			if (lines < 0) throw new ArgumentOutOfRangeException("lines");
+			if (tracks < 0) throw new ArgumentOutOfRangeException("tracks");
+			
+			lock (sync)
+			{
+				Unpack();
+				int oldTracks = Tracks;
+				if (data != null && lines == this.lines && tracks == oldTracks) return;
+				
+				byte[] cells = new byte[lines * tracks * PsyFile.EventSize];
+				int keepLines = data == null ? 0 : Math.Min(lines, this.lines);
+				int lineSize = tracks * PsyFile.EventSize;
+				if (data != null && tracks == oldTracks)
+				{
+					// Same line layout, one copy for all the lines kept.
+					Buffer.BlockCopy(data, 0, cells, 0, keepLines * lineSize);
+					FillBlank(cells, keepLines * lineSize, cells.Length - keepLines * lineSize);
+				}
+				else
+				{
+					FillBlank(cells, 0, cells.Length);
+					int keep = Math.Min(tracks, oldTracks) * PsyFile.EventSize;
+					for (int line = 0; line < keepLines; line++)
+					{
+						Buffer.BlockCopy(data, line * oldTracks * PsyFile.EventSize, cells, line * lineSize, keep);
+					}
+				}
+				data = cells;
+				packed = null;
+				shared = false;
+				this.lines = lines;
+			}
+			MarkDirty();
+		}
+		
+		// The cells with each line cut or padded with blank cells to tracks, as
+		// Song::Load reads them with the song's track count. Not kept.
+		internal byte[] GetCells(int tracks)
+		{
+			lock (sync)
+			{
+				byte[] cells = ReadOnlyData;
+				int oldTracks = Tracks;
+				if (cells == null || tracks == oldTracks) return cells;
+				
+				byte[] lines = new byte[this.lines * tracks * PsyFile.EventSize];
+				FillBlank(lines, 0, lines.Length);
+				int keep = Math.Min(tracks, oldTracks) * PsyFile.EventSize;
+				for (int line = 0; line < this.lines; line++)
+				{
+					Buffer.BlockCopy(cells, line * oldTracks * PsyFile.EventSize, lines, line * tracks * PsyFile.EventSize, keep);
+				}
+				return lines;
+			}
+		}
+		
+		// Changes the lines keeping the cells where they fall in time, as
+		// Song::AllocNewPattern does with adaptsize: shrinking keeps every step-th
+		// line, stretching spreads the lines out with blank lines between them.
+		public void Stretch(int lines)
+		{
+			if (lines <= 0) throw new ArgumentOutOfRangeException("lines");
+			
+			lock (sync)
+			{
+				Unpack();
+				if (data == null || lines == this.lines || this.lines == 0)
+				{
+					Resize(lines, Tracks);
+					return;
+				}
+				
+				// Whole lines are copied, so the map is worked out once for all tracks.
+				int[] map = StretchMap(this.lines, lines);
+				int lineSize = Tracks * PsyFile.EventSize;
+				byte[] cells = new byte[lines * lineSize];
+				FillBlank(cells, 0, cells.Length);
+				for (int line = 0; line < lines; line++)
+				{
+					if (map[line] >= 0) Buffer.BlockCopy(data, map[line] * lineSize, cells, line * lineSize, lineSize);
+				}
+				data = cells;
+				shared = false;
+				this.lines = lines;
+			}
+			MarkDirty();
+		}
+		
+		// Old line for each new line, -1 for the blank ones. Rounded in float as
+		// psycle does, so stretched songs line up with the ones it stretches.
+		static int[] StretchMap(int oldLines, int newLines)
+		{
+			int[] map = new int[newLines];
+			if (oldLines > newLines)
+			{
+				float step = (float)oldLines / newLines;
+				for (int line = 0; line < newLines; line++)
+				{
+					map[line] = Math.Min(oldLines - 1, Round(line * step));
+				}
+			}
+			else
+			{
+				float step = (float)newLines / oldLines;
+				for (int line = 0; line < newLines; line++) map[line] = -1;
+				for (int line = 0; line < oldLines; line++)
+				{
+					map[Math.Min(newLines - 1, Round(line * step))] = line;
+				}
+			}
+			return map;
+		}
+		
+		static int Round(float value)
+		{
+			return (int)Math.Round(value, MidpointRounding.AwayFromZero);
+		}
+		
+		// Moves the tracks from track on one to the right, and blanks track.
+		public void InsertTrack(int track)
+		{
+			lock (sync)
+			{
+				if (columns != null)
+				{
+					columns.InsertTrack(track);
+				}
+				else
+				{
+					Unpack();
+					int tracks = Tracks;
+					if (track < 0 || track > tracks) throw new ArgumentOutOfRangeException("track");
+					
+					byte[] cells = new byte[lines * (tracks + 1) * PsyFile.EventSize];
+					int before = track * PsyFile.EventSize;
+					int after = (tracks - track) * PsyFile.EventSize;
+					for (int line = 0, s = 0, d = 0; line < lines; line++)
+					{
+						Buffer.BlockCopy(data, s, cells, d, before);
+						Buffer.BlockCopy(BlankCell, 0, cells, d + before, PsyFile.EventSize);
+						Buffer.BlockCopy(data, s + before, cells, d + before + PsyFile.EventSize, after);
+						s += before + after;
+						d += before + PsyFile.EventSize + after;
+					}
+					data = cells;
+					shared = false;
+				}
+			}
+			MarkDirty();
+		}
+		
+		// Makes the pattern use the cells of source, which hold the same bytes.
+		// Both copy them before their next write. The revision is kept, since
+		// the content does not change.
+		internal void ShareCells(PsyPattern source)
+		{
+			byte[] cells;
+			lock (source.sync)
+			{
+				source.Unpack();
+				cells = source.data;
+				if (cells == null) return;
+				source.shared = true;
+			}
+			lock (sync)
+			{
+				data = cells;
+				packed = null;
+				sparse = null;
+				columns = null;
+				shared = true;
+			}
+		}
+		
+		// True when both patterns already hold the same cells array.
+		internal bool SharesCellsWith(PsyPattern other)
+		{
+			byte[] cells;
+			lock (sync)
+			{
+				cells = data;
+			}
+			lock (other.sync)
+			{
+				return cells != null && ReferenceEquals(cells, other.data);
+			}
+		}
+		
+		// Fills count bytes from offset with blank cells: one cell, then copies of
+		// what is already filled, doubling each time.
+		public static void FillBlank(byte[] cells, int offset, int count)
+		{
+			if (cells == null) throw new ArgumentNullException("cells");
+			if (count <= 0) return;
+			
+			Buffer.BlockCopy(BlankCell, 0, cells, offset, Math.Min(PsyFile.EventSize, count));
+			for (int filled = PsyFile.EventSize; filled < count; filled *= 2)
+			{
+				Buffer.BlockCopy(cells, offset, cells, offset + filled, Math.Min(filled, count - filled));
+			}
+		}
+		
+		public void SetEvent(int line, int track, byte note, byte inst, byte mach, byte cmd, byte parameter)
+		{
+			if (line < 0 || line >= Lines) throw new ArgumentOutOfRangeException("line");
+			if (track < 0 || track >= Tracks) throw new ArgumentOutOfRangeException("track");
+			
+			int cell = line * Tracks + track;
+			bool blank = IsBlank(note, inst, mach, cmd, parameter);
+			lock (sync)
+			{
+				// Keeps the count of used cells when it is up to date.
+				bool counted = usedCellsRevision == Revision;
+				if (sparse != null)
+				{
+					sparse.Set(cell, note, inst, mach, cmd, parameter);
+					usedCells = sparse.Count;
+				}
+				else if (columns != null)
+				{
+					if (counted)
+					{
+						bool wasBlank = columns.IsBlank(line, track);
+						if (wasBlank && !blank) usedCells++;
+						else if (!wasBlank && blank) usedCells--;
+					}
+					columns.SetEvent(line, track, note, inst, mach, cmd, parameter);
+				}
+				else
+				{
+					Unpack();
+					if (shared)
+					{
+						data = (byte[])data.Clone();
+						shared = false;
+					}
+					int i = cell * PsyFile.EventSize;
+					if (counted)
+					{
+						bool wasBlank = IsBlank(data[i], data[i + 1], data[i + 2], data[i + 3], data[i + 4]);
+						if (wasBlank && !blank) usedCells++;
+						else if (!wasBlank && blank) usedCells--;
+					}
+					data[i] = note;
+					data[i + 1] = inst;
+					data[i + 2] = mach;
+					data[i + 3] = cmd;
+					data[i + 4] = parameter;
+				}
+				MarkDirty();
+				if (counted || sparse != null) usedCellsRevision = Revision;
+			}
+		}
+		
+		// Cells that are not blank. Counted once and then kept up to date by
+		// SetEvent; code that writes into Data and calls MarkDirty has them counted again.
+		public int UsedCells
+		{
+			get
+			{
+				lock (sync)
+				{
+					int current = Revision;
+					if (usedCellsRevision != current)
+					{
+						usedCells = sparse != null ? sparse.Count : CountUsed(ReadOnlyData);
+						usedCellsRevision = current;
+					}
+					return usedCells;
+				}
+			}
+		}
+		
+		public bool IsEmpty()
+		{
+			return UsedCells == 0;
+		}
+		
+		// Few enough cells used for Compact to pay off, see SparseCellRatio.
+		public bool IsMostlyBlank()
+		{
+			return UsedCells * SparseCellRatio <= UnpackedSize / PsyFile.EventSize;
+		}
+		
+		static int CountUsed(byte[] cells)
+		{
+			if (cells == null) return 0;
+			return PsyCellScan.CountUsed(cells, 0, cells.Length);
+		}
+		
+		static bool IsBlank(byte note, byte inst, byte mach, byte cmd, byte parameter)
+		{
+			return note == EmptyNote && inst == EmptyInst && mach == EmptyMach && cmd == 0 && parameter == 0;
+		}
+
+		// A copy of the pattern as it is now, sharing the cells until either side
+		// asks for Data. It also shares EncodedChunk, so saving the snapshot
+		// fills the cache for the pattern.
+		public PsyPattern Snapshot()
+		{
+			lock (sync)
+			{
+				PsyPattern copy = new PsyPattern();
+				copy.index = index;
+				copy.lines = lines;
+				copy.name = name;
+				copy.trackNames = trackNames == null ? null : (string[])trackNames.Clone();
+				copy.data = data;
+				copy.packed = packed;
+				copy.sparse = sparse == null ? null : sparse.Clone();
+				copy.columns = columns == null ? null : columns.Clone();
+				copy.revision = Revision;
+				copy.usedCells = usedCells;
+				copy.usedCellsRevision = usedCellsRevision;
+				copy.EncodedChunk = EncodedChunk;
+				if (data != null)
+				{
+					copy.shared = true;
+					shared = true;
+				}
+				return copy;
+			}
+		}
+		
+		public override string ToString ()
+		{
+			return string.Format ("[PsyPattern: Index={0}, Lines={1}, Tracks={2}, Name={3}]", Index, Lines, Tracks, Name);
+		}
+	}
+}
@@ -0,0 +1,13 @@
+using System;
+
+namespace PsyFile
+{
+	// How PsyBinaryWriter compresses PATD data.
+	public enum PsyPatternCodec
+	{
+		// Version 1 chunks, readable by psycle.
+		BeerZ77,
+		// Version 0x0101 chunks, see PsyColumnCodec. Only this library reads them.
+		Columns
+	}
+}
@@ -0,0 +1,208 @@
+using System;
+
+namespace PsyFile
+{
+	// The cells of a pattern split by field, one array per field, with each
+	// track's lines next to each other (track * Lines + line). Work on one track
+	// or one field, such as inserting a track or looking through the notes, is a
+	// contiguous pass instead of a walk over lines at the pattern's stride.
+	//
+	// PsyPattern keeps its cells in one after UseColumns, until Data is asked for.
+	public class PsyPatternColumns
+	{
+		public const int NoteField = 0;
+		public const int InstField = 1;
+		public const int MachField = 2;
+		public const int CmdField = 3;
+		public const int ParameterField = 4;
+
+		static readonly byte[] BlankFields = { PsyPattern.EmptyNote, PsyPattern.EmptyInst, PsyPattern.EmptyMach, 0, 0 };
+
+		byte[][] fields = new byte[PsyFile.EventSize][];
+
+		// All cells blank.
+		public PsyPatternColumns (int lines, int tracks)
+		{
+			if (lines < 0) throw new ArgumentOutOfRangeException("lines");
+			if (tracks < 0) throw new ArgumentOutOfRangeException("tracks");
+
+			Lines = lines;
+			Tracks = tracks;
+			for (int f = 0; f < fields.Length; f++)
+			{
+				fields[f] = new byte[lines * tracks];
+				Fill(fields[f], 0, fields[f].Length, BlankFields[f]);
+			}
+		}
+
+		public int Lines { get; private set; }
+		public int Tracks { get; private set; }
+
+		public byte[] Notes
+		{
+			get { return fields[NoteField]; }
+		}
+
+		public byte[] Instruments
+		{
+			get { return fields[InstField]; }
+		}
+
+		public byte[] Machines
+		{
+			get { return fields[MachField]; }
+		}
+
+		public byte[] Commands
+		{
+			get { return fields[CmdField]; }
+		}
+
+		public byte[] Parameters
+		{
+			get { return fields[ParameterField]; }
+		}
+
+		public byte[] GetField(int field)
+		{
+			if (field < 0 || field >= fields.Length) throw new ArgumentOutOfRangeException("field");
+			return fields[field];
+		}
+
+		// Where the track starts in each field array.
+		public int GetTrackOffset(int track)
+		{
+			if (track < 0 || track >= Tracks) throw new ArgumentOutOfRangeException("track");
+			return track * Lines;
+		}
+
+		// From cells laid out as PsyPattern.Data, line after line.
+		public static PsyPatternColumns FromCells(byte[] cells, int lines, int tracks)
+		{
+			if (cells == null) throw new ArgumentNullException("cells");
+
+			PsyPatternColumns columns = new PsyPatternColumns(lines, tracks);
+			if (cells.Length < lines * tracks * PsyFile.EventSize) throw new ArgumentException("The cells are fewer than lines x tracks.", "cells");
+
+			byte[] note = columns.Notes, inst = columns.Instruments, mach = columns.Machines, cmd = columns.Commands, parameter = columns.Parameters;
+			for (int track = 0; track < tracks; track++)
+			{
+				int d = track * lines;
+				for (int line = 0, s = track * PsyFile.EventSize; line < lines; line++, d++, s += tracks * PsyFile.EventSize)
+				{
+					note[d] = cells[s];
+					inst[d] = cells[s + 1];
+					mach[d] = cells[s + 2];
+					cmd[d] = cells[s + 3];
+					parameter[d] = cells[s + 4];
+				}
+			}
+			return columns;
+		}
+
+		// Cells laid out as PsyPattern.Data.
+		public byte[] ToCells()
+		{
+			byte[] cells = new byte[Lines * Tracks * PsyFile.EventSize];
+			byte[] note = Notes, inst = Instruments, mach = Machines, cmd = Commands, parameter = Parameters;
+			for (int track = 0; track < Tracks; track++)
+			{
+				int s = track * Lines;
+				for (int line = 0, d = track * PsyFile.EventSize; line < Lines; line++, s++, d += Tracks * PsyFile.EventSize)
+				{
+					cells[d] = note[s];
+					cells[d + 1] = inst[s];
+					cells[d + 2] = mach[s];
+					cells[d + 3] = cmd[s];
+					cells[d + 4] = parameter[s];
+				}
+			}
+			return cells;
+		}
+
+		public bool IsBlank(int line, int track)
+		{
+			int i = Cell(line, track);
+			return fields[NoteField][i] == PsyPattern.EmptyNote && fields[InstField][i] == PsyPattern.EmptyInst
+				&& fields[MachField][i] == PsyPattern.EmptyMach && fields[CmdField][i] == 0 && fields[ParameterField][i] == 0;
+		}
+
+		public void SetEvent(int line, int track, byte note, byte inst, byte mach, byte cmd, byte parameter)
+		{
+			int i = Cell(line, track);
+			fields[NoteField][i] = note;
+			fields[InstField][i] = inst;
+			fields[MachField][i] = mach;
+			fields[CmdField][i] = cmd;
+			fields[ParameterField][i] = parameter;
+		}
+
+		public byte GetField(int line, int track, int field)
+		{
+			int i = Cell(line, track);
+			if (field < 0 || field >= fields.Length) throw new ArgumentOutOfRangeException("field");
+			return fields[field][i];
+		}
+
+		int Cell(int line, int track)
+		{
+			if (line < 0 || line >= Lines) throw new ArgumentOutOfRangeException("line");
+			if (track < 0 || track >= Tracks) throw new ArgumentOutOfRangeException("track");
+			return track * Lines + line;
+		}
+
+		public PsyPatternColumns Clone()
+		{
+			PsyPatternColumns copy = (PsyPatternColumns)MemberwiseClone();
+			copy.fields = new byte[fields.Length][];
+			for (int f = 0; f < fields.Length; f++)
+			{
+				copy.fields[f] = (byte[])fields[f].Clone();
+			}
+			return copy;
+		}
+
+		// Moves the tracks from track on one to the right and blanks track: two
+		// copies per field, whatever the number of lines.
+		public void InsertTrack(int track)
+		{
+			if (track < 0 || track > Tracks) throw new ArgumentOutOfRangeException("track");
+
+			int before = track * Lines;
+			int after = (Tracks - track) * Lines;
+			for (int f = 0; f < fields.Length; f++)
+			{
+				byte[] field = new byte[before + Lines + after];
+				Buffer.BlockCopy(fields[f], 0, field, 0, before);
+				Fill(field, before, Lines, BlankFields[f]);
+				Buffer.BlockCopy(fields[f], before, field, before + Lines, after);
+				fields[f] = field;
+			}
+			Tracks++;
+		}
+
+		// Line of the first note in the track from line on, or -1.
+		public int FindNote(int track, int line)
+		{
+			int from = Cell(line, track);
+			int end = track * Lines + Lines;
+			byte[] note = Notes;
+			for (int i = from; i < end; i++)
+			{
+				if (note[i] != PsyPattern.EmptyNote) return i - track * Lines;
+			}
+			return -1;
+		}
+
+		static void Fill(byte[] array, int offset, int count, byte value)
+		{
+			if (count <= 0) return;
+
+			array[offset] = value;
+			for (int filled = 1; filled < count; filled *= 2)
+			{
+				Buffer.BlockCopy(array, offset, array, offset + filled, Math.Min(filled, count - filled));
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+using System;
+using System.Diagnostics;
+using System.Threading;
+
+namespace PsyFile
+{
+	// Progress of a load or save, passed on to a callback at most once per
+	// Interval so that reporting every chunk costs next to nothing. Cancelling
+	// the token makes the next Report throw OperationCanceledException.
+	public class PsyProgress
+	{
+		readonly Action<int, int> callback;
+		readonly Stopwatch clock = Stopwatch.StartNew();
+		long lastReport;
+		readonly object sync = new object();
+		
+		public PsyProgress(Action<int, int> callback)
+			: this(callback, CancellationToken.None)
+		{
+		}
+		
+		// The callback gets the number of chunks done and the total.
+		public PsyProgress(Action<int, int> callback, CancellationToken cancellationToken)
+		{
+			this.callback = callback;
+			this.CancellationToken = cancellationToken;
+			this.Interval = TimeSpan.FromMilliseconds(100);
+		}
+		
+		public CancellationToken CancellationToken { get; private set; }
+		public TimeSpan Interval { get; set; }
+		
+		// The last step is always passed on, the others only once Interval has passed.
+		public void Report(int done, int total)
+		{
+			CancellationToken.ThrowIfCancellationRequested();
+			if (callback == null) return;
+			
+			lock (sync)
+			{
+				long now = clock.ElapsedTicks;
+				if (done < total && now - lastReport < Interval.TotalSeconds * Stopwatch.Frequency) return;
+				lastReport = now;
+			}
+			callback(done, total);
+		}
+	}
+}
@@ -0,0 +1,45 @@
+using System;
+
+namespace PsyFile
+{
+	public class PsyReadOptions
+	{
+		// Read through a PsyMappedFile instead of a FileStream.
+		public bool MemoryMapped { get; set; }
+		
+		// Chunks to decode. The others are only listed in PsyFile.Chunks.
+		public PsyChunkKinds Chunks { get; set; }
+		
+		// Keep PATD data compressed until a pattern's Data is first used.
+		public bool LazyPatterns { get; set; }
+		
+		// With LazyPatterns, decompress the patterns on a background thread after loading.
+		public bool PrefetchPatterns { get; set; }
+		
+		// Leave INSD wave data in the file until a wave's packed data is asked for.
+		// The reader has to stay open for as long as the waves are used.
+		public bool LazyWaves { get; set; }
+		
+		// With LazyWaves, read the waves of the instruments used by the patterns
+		// on a background thread after loading.
+		public bool PrefetchWaves { get; set; }
+		
+		// Keep only the cells that are not blank in mostly blank patterns, see
+		// PsyPattern.Compact and IsMostlyBlank. Not with LazyPatterns.
+		public bool SparsePatterns { get; set; }
+		
+		// Keep the cells by track and field, see PsyPattern.UseColumns. Not with LazyPatterns or SparsePatterns.
+		public bool ColumnPatterns { get; set; }
+		
+		// Copies of a pattern share one set of cells, see PsyFile.SharePatterns. Not with LazyPatterns.
+		public bool SharePatterns { get; set; }
+		
+		// Told about every chunk read, and checked for cancellation. Null for none.
+		public PsyProgress Progress { get; set; }
+		
+		public PsyReadOptions ()
+		{
+			Chunks = PsyChunkKinds.All;
+		}
+	}
+}
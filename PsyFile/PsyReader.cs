@@ -1,31 +1,97 @@
 using System;
+using System.Collections.Generic;
 using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
 
 namespace PsyFile
 {
-	public class PsyReader
+	public class PsyReader : IDisposable
 	{
 		public PsyFile Psyfile;
 		protected string FilePath;
-		protected BinaryReader Reader;
+		protected PsyReadOptions Options;
+		protected PsyRiffFile Riff;
+		bool songPropertiesRead;
+		int chunksRead;
+		// Prefetches still reading from Riff, stopped and waited for before it is closed.
+		readonly List<Task> prefetches = new List<Task>();
+		readonly CancellationTokenSource prefetchCancel = new CancellationTokenSource();
+		
+		// PATD chunks read so far, in file order, committed once all chunks are read.
+		readonly List<PsyPattern> patterns = new List<PsyPattern>();
+		readonly List<long> patternOffsets = new List<long>();
+		readonly List<int> patternSizes = new List<int>();
+		// Column coded data of each pattern, null for z77 data.
+		readonly List<byte[]> patternColumns = new List<byte[]>();
+		
+		static readonly string[] KnownChunkIds = { "INFO", "SNGI", "SEQD", "PATD", "MACD", "INSD", "EINS" };
+		const int ChunkHeaderSize = 12;
+		const int ResyncWindow = 1 << 16;
+		const uint EinsTag = 0x534E4945;
+		
+		// KnownChunkIds as little endian ints, to compare four bytes at once.
+		static readonly uint[] KnownChunkTags = { 0x4F464E49, 0x49474E53, 0x44514553, 0x44544150, 0x4443414D, 0x44534E49, EinsTag };
 		
 		public PsyReader(string filePath, PsyFile psyfile)
+			: this(filePath, psyfile, new PsyReadOptions())
+		{
+		}
+		
+		public PsyReader(string filePath, PsyFile psyfile, PsyReadOptions options)
 		{
 			if (String.IsNullOrEmpty(filePath)) throw new ArgumentNullException("filePath");
 			if (psyfile == null) throw new ArgumentNullException("psyfile");
+			if (options == null) throw new ArgumentNullException("options");
 			
 			this.FilePath = filePath;
 			this.Psyfile = psyfile;
+			this.Options = options;
 			
 			OpenPsyBinary();
 			ReadPsyBinary();
 		}
 		
+		public PsyReader(Stream stream, PsyFile psyfile)
+			: this(stream, psyfile, new PsyReadOptions())
+		{
+		}
+		
+		// Reads from any stream, such as a song kept in memory. Streams that cannot
+		// seek, such as pipes, are read in a single forward pass, with the pattern
+		// and wave data copied into memory as it goes by.
+		public PsyReader(Stream stream, PsyFile psyfile, PsyReadOptions options)
+		{
+			if (stream == null) throw new ArgumentNullException("stream");
+			if (psyfile == null) throw new ArgumentNullException("psyfile");
+			if (options == null) throw new ArgumentNullException("options");
+			
+			this.Psyfile = psyfile;
+			this.Options = options;
+			if (stream.CanSeek)
+			{
+				this.Riff = new PsyStreamFile(stream);
+			}
+			else
+			{
+				this.Riff = new PsyForwardFile(stream);
+			}
+			
+			ReadPsyBinary();
+		}
+		
 		protected void OpenPsyBinary()
 		{
 			if (File.Exists(FilePath))
 			{
-				Reader = new BinaryReader(File.Open(FilePath, FileMode.Open));
+				if (Options.MemoryMapped)
+				{
+					Riff = new PsyMappedFile(FilePath);
+				}
+				else
+				{
+					Riff = new PsyStreamFile(File.Open(FilePath, FileMode.Open, FileAccess.Read));
+				}
 			}
 			else
 			{
@@ -35,48 +101,473 @@ namespace PsyFile
 
 		public void ReadPsyBinary()
 		{
-			if (Reader == null) throw new ArgumentNullException("reader");
+			if (Riff == null) throw new ArgumentNullException("riff");
 			
 			ReadFileInfo();
+			ScanChunks();
+			ReadChunks();
+		}
+
+		void ReadFileInfo()
+		{
+			Psyfile.PsyVersion = ReadPsyVersion();
+			if (Psyfile.PsyVersion != "PSY3SONG")
+			{
+				throw new Exception("Expected to read PSY3SONG header.");
+			}
+			Psyfile.ChunkVersion = ReadVersion();
+			Psyfile.Size = ReadSize();
+			Psyfile.ChunkCount = ReadChunkCount();
+			if (Psyfile.Size > 4)
+			{
+				// Skip any extra data a newer file version could add to the header.
+				Riff.Skip(Psyfile.Size - 4);
+			}
+		}
+		
+		// First pass: read only the chunk headers and build the table of contents,
+		// seeking over every chunk body. When the file cannot seek, each chunk is
+		// decoded as soon as its header is found instead.
+		void ScanChunks()
+		{
+			int remaining = Psyfile.ChunkCount;
+			Psyfile.Chunks.Clear();
+			
+			while (remaining > 0 && Riff.IsAvailable(ChunkHeaderSize))
+			{
+				if (Options.Progress != null) Options.Progress.CancellationToken.ThrowIfCancellationRequested();
+				
+				string id = Riff.ReadId(4);
+				if (Array.IndexOf(KnownChunkIds, id) < 0)
+				{
+					// We are not at a valid header, probably there is some extra data.
+					// Song::Load shifts back 3 bytes and tries again, byte by byte.
+					if (!FindChunkHeader(Riff.Position - 3)) break;
+					continue;
+				}
+				
+				PsyChunk chunk = new PsyChunk();
+				chunk.Id = id;
+				chunk.Version = ReadVersion();
+				chunk.Size = ReadSize();
+				chunk.Offset = Riff.Position;
+				FixChunkSize(chunk);
+				Psyfile.Chunks.Add(chunk);
+				remaining--;
+				
+				if (!Riff.CanSeek) ReadChunk(chunk);
+				Riff.Position = chunk.Offset + chunk.Size;
+			}
+		}
+		
+		// Searches from offset for the next known chunk id followed by a plausible
+		// version and size, a window at a time, and leaves Position on it.
+		bool FindChunkHeader(long offset)
+		{
+			while (true)
+			{
+				Riff.Position = offset;
+				byte[] window = Riff.Peek(ResyncWindow);
+				int last = window.Length - ChunkHeaderSize;
+				if (last < 0) return false;
+				
+				for (int i = 0; i <= last; i++)
+				{
+					// All ids start with one of these, which skips most bytes with one compare.
+					byte b = window[i];
+					if (b != 'I' && b != 'S' && b != 'P' && b != 'M' && b != 'E') continue;
+					
+					uint tag = (uint)(b | (window[i + 1] << 8) | (window[i + 2] << 16) | (window[i + 3] << 24));
+					if (Array.IndexOf(KnownChunkTags, tag) >= 0 && IsPlausibleHeader(tag, window, i, offset + i))
+					{
+						Riff.Position = offset + i;
+						return true;
+					}
+				}
+				// The next window starts where a header no longer fitted in this one.
+				offset += last + 1;
+			}
+		}
+		
+		bool IsPlausibleHeader(uint tag, byte[] window, int i, long offset)
+		{
+			int version = window[i + 4] | (window[i + 5] << 8) | (window[i + 6] << 16) | (window[i + 7] << 24);
+			int size = window[i + 8] | (window[i + 9] << 8) | (window[i + 10] << 16) | (window[i + 11] << 24);
+			if (size < 0) return false;
+			// EINS keeps the XMSampler version in the high 16 bits, the others are small.
+			if (tag != EinsTag && (version < 0 || version > 0xFFFF)) return false;
+			// Four more bytes for the PATD size fixed up by FixChunkSize.
+			return !Riff.CanSeek || offset + ChunkHeaderSize + size <= Riff.Length + 4;
+		}
+		
+		// Older psycle versions wrote wrong sizes for some chunks. Song::Load corrects
+		// them while decoding; the scan has to do it up front to find the next header.
+		void FixChunkSize(PsyChunk chunk)
+		{
+			if (chunk.Version != 0) return;
+			
+			if (chunk.Id == "INFO")
+			{
+				ReadTitle();
+				ReadArtist();
+				ReadComments();
+				chunk.Size = (int)(Riff.Position - chunk.Offset);
+			}
+			else if (chunk.Id == "SNGI")
+			{
+				int tracks = Riff.ReadInt32();
+				chunk.Size = 11 * sizeof(int) + tracks * 2 * sizeof(bool);
+			}
+			else if (chunk.Id == "PATD")
+			{
+				// Versions prior to 1.8 saved one less int in the size.
+				Riff.ReadInt32(); // index
+				Riff.ReadInt32(); // lines
+				Riff.ReadInt32(); // tracks
+				Riff.ReadString(32);
+				uint sizez77 = Riff.ReadUInt32();
+				if (Riff.Position + sizez77 == chunk.Offset + chunk.Size + 4)
+				{
+					chunk.Size += 4;
+				}
+			}
+		}
+		
+		// Second pass: decode the chunks listed in the table of contents.
+		void ReadChunks()
+		{
+			if (Riff.CanSeek)
+			{
+				foreach (PsyChunk chunk in Psyfile.Chunks)
+				{
+					ReadChunk(chunk);
+				}
+			}
 			
-			char[] headerChars = new char[4];
-			Reader.Read(headerChars, 0, 4);
-			string header = new string(headerChars);
+			CommitPatterns();
+			if (Options.Progress != null) Options.Progress.Report(Psyfile.Chunks.Count, Psyfile.Chunks.Count);
+			if (Options.LazyPatterns && Options.PrefetchPatterns)
+			{
+				prefetches.Add(Psyfile.PrefetchPatterns(prefetchCancel.Token));
+			}
+			if (Options.LazyWaves && Options.PrefetchWaves)
+			{
+				prefetches.Add(Psyfile.PrefetchWaves(prefetchCancel.Token));
+			}
+		}
+		
+		void ReadChunk(PsyChunk chunk)
+		{
+			if (Options.Progress != null) Options.Progress.Report(chunksRead++, Psyfile.ChunkCount);
+			if (!IsSupported(chunk) || (Options.Chunks & chunk.Kind) == 0) return;
 			
-			if (header == "INFO")
+			Riff.Position = chunk.Offset;
+			if (chunk.Id == "INFO")
 			{
 				ReadSongBasicInfo();
 			}
-			else
+			else if (chunk.Id == "SNGI")
+			{
+				ReadSongProperties(chunk);
+			}
+			else if (chunk.Id == "SEQD")
+			{
+				ReadSequence();
+			}
+			else if (chunk.Id == "PATD")
+			{
+				ReadPattern(chunk);
+			}
+			else if (chunk.Id == "INSD")
+			{
+				ReadInstrument(chunk);
+			}
+			else if (chunk.Id == "MACD")
 			{
-				throw new Exception("Expected to read INFO header.");		
+				ReadMachine();
+				Riff.Position = chunk.Offset;
+				chunk.Data = ReadChunkBody(chunk);
+			}
+			else if (chunk.Id == "EINS")
+			{
+				chunk.Data = ReadChunkBody(chunk);
 			}
 		}
-
-		void ReadFileInfo()
+		
+		// Major version zero, as in Song::Load, and the column coded PATD chunks
+		// PsyBinaryWriter can write.
+		static bool IsSupported(PsyChunk chunk)
 		{
-			Psyfile.PsyVersion = ReadPsyVersion();
-			Psyfile.ChunkVersion = ReadVersion();
-			Psyfile.Size = ReadSize();
-			Psyfile.ChunkCount = ReadChunkCount();
+			if (chunk.IsMajorZero) return true;
+			return chunk.Id == "PATD" && (chunk.Version & 0xFF00) == (PsyBinaryWriter.ColumnsVersionPatd & 0xFF00);
+		}
+		
+		// The body of a chunk kept undecoded. The last chunk of a seekable file may be cut short.
+		byte[] ReadChunkBody(PsyChunk chunk)
+		{
+			if (!Riff.CanSeek) return Riff.ReadBytes(chunk.Size);
+			return Riff.ReadBytes((int)Math.Min(chunk.Size, Riff.Length - chunk.Offset));
 		}
 		
 		void ReadSongBasicInfo()
 		{
-			Reader.ReadUInt32(); // version
-			Reader.ReadUInt32(); // size
 			Psyfile.Title = ReadTitle();
 			Psyfile.Artist = ReadArtist();
 			Psyfile.Comments = ReadComments();
 		}
+		
+		void ReadSongProperties(PsyChunk chunk)
+		{
+			PsyLayouts.SongProperties.Decode(Riff.ReadBytes(PsyLayouts.SongProperties.Size), Psyfile);
+			
+			int tracks = Math.Max(0, Math.Min(Psyfile.Tracks, PsyFile.MaxTracks));
+			Psyfile.TrackMuted = new bool[tracks];
+			Psyfile.TrackArmed = new bool[tracks];
+			PsyLayouts.DecodeTrackFlags(Riff.ReadBytes(2 * tracks), Psyfile.TrackMuted, Psyfile.TrackArmed);
+			
+			Psyfile.ShareTrackNames = false;
+			Psyfile.TrackNames = new string[0];
+			if (chunk.Version > 0)
+			{
+				Psyfile.ShareTrackNames = Riff.ReadBoolean();
+				if (Psyfile.ShareTrackNames)
+				{
+					Psyfile.TrackNames = ReadTrackNames();
+				}
+			}
+			songPropertiesRead = true;
+		}
+		
+		void ReadSequence()
+		{
+			// Index, for multipattern. Only the first sequence is used.
+			int index = Riff.ReadInt32();
+			if (index != 0) return;
+			
+			int length = Riff.ReadInt32();
+			Psyfile.SequenceName = Riff.ReadString(32);
+			Psyfile.PlayOrder = PsyLayouts.DecodeInt32s(Riff.ReadBytes(Math.Max(0, length) * sizeof(int)));
+		}
+		
+		string[] ReadTrackNames()
+		{
+			string[] names = new string[Psyfile.TrackMuted.Length];
+			for (int t = 0; t < names.Length; t++)
+			{
+				names[t] = Riff.ReadString(32);
+			}
+			return names;
+		}
+		
+		// The PATD headers are read in file order. The z77 data stays in the file
+		// until CommitPatterns, unless it has to be kept packed (LazyPatterns) or
+		// the file cannot seek back to it.
+		void ReadPattern(PsyChunk chunk)
+		{
+			PsyPattern pattern = new PsyPattern();
+			pattern.Index = Riff.ReadInt32();
+			pattern.Lines = Riff.ReadInt32();
+			Riff.ReadInt32(); // tracks, the data is stored with the song's track count.
+			pattern.Name = Riff.ReadString(32);
+			int sizez77 = (int)Riff.ReadUInt32();
+			if (pattern.Index < 0 || pattern.Index >= PsyFile.MaxPatterns) return;
+			
+			long offset = Riff.Position;
+			byte[] columns = null;
+			if (!chunk.IsMajorZero)
+			{
+				// Only z77 data is kept packed, column coded data is quick to decode.
+				columns = Riff.ReadBytes(sizez77);
+			}
+			else if (Options.LazyPatterns || !Riff.CanSeek)
+			{
+				pattern.Packed = Riff.ReadBytes(sizez77);
+			}
+			else
+			{
+				Riff.Skip(sizez77);
+			}
+			// Per pattern track names need SNGI to know that the song does not share them.
+			if ((chunk.Version & 0xFF) > 0 && songPropertiesRead && !Psyfile.ShareTrackNames)
+			{
+				pattern.TrackNames = ReadTrackNames();
+			}
+			
+			patterns.Add(pattern);
+			patternOffsets.Add(offset);
+			patternSizes.Add(sizez77);
+			patternColumns.Add(columns);
+		}
+		
+		// The data of all patterns is decoded at the same time on the thread pool.
+		// With LazyPatterns, z77 data is kept for later.
+		void CommitPatterns()
+		{
+			ParallelOptions parallel = new ParallelOptions();
+			if (Options.Progress != null) parallel.CancellationToken = Options.Progress.CancellationToken;
+			Parallel.For(0, patterns.Count, parallel, i =>
+			{
+				if (patternColumns[i] != null)
+				{
+					patterns[i].Data = PsyColumnCodec.Decode(patternColumns[i]);
+				}
+				else if (Options.LazyPatterns)
+				{
+					return;
+				}
+				else if (patterns[i].Packed != null)
+				{
+					patterns[i].Data = BeerZ77.Decompress(patterns[i].Packed);
+				}
+				else
+				{
+					patterns[i].Data = Riff.DecompressZ77(patternOffsets[i], patternSizes[i]);
+				}
+				if (Options.SparsePatterns)
+				{
+					if (patterns[i].IsMostlyBlank()) patterns[i].Compact();
+				}
+				else if (Options.ColumnPatterns) patterns[i].UseColumns();
+			});
+			
+			// Committed in file order, so a later chunk for the same index wins like in Song::Load.
+			foreach (PsyPattern pattern in patterns)
+			{
+				Psyfile.Patterns[pattern.Index] = pattern;
+			}
+			if (Options.SharePatterns) Psyfile.SharePatterns();
+			patterns.Clear();
+			patternOffsets.Clear();
+			patternSizes.Clear();
+			patternColumns.Clear();
+		}
+
+		void ReadMachine()
+		{
+			int index = Riff.ReadInt32();
+			if (index < 0 || index >= PsyFile.MaxMachines) return;
+			
+			PsyMachine machine = new PsyMachine();
+			machine.Index = index;
+			machine.Type = Riff.ReadInt32();
+			machine.DllName = Riff.ReadString(256);
+			machine.Bypass = Riff.ReadBoolean();
+			machine.Mute = Riff.ReadBoolean();
+			machine.Pan = Riff.ReadInt32();
+			machine.X = Riff.ReadInt32();
+			machine.Y = Riff.ReadInt32();
+			Riff.ReadInt32(); // numInputs, recounted from the wires.
+			Riff.ReadInt32(); // numOutputs
+			for (int c = 0; c < PsyMachine.MaxConnections; c++)
+			{
+				int input = Riff.ReadInt32();
+				int output = Riff.ReadInt32();
+				Riff.ReadInt32(); // inputConVol
+				Riff.ReadInt32(); // wireMultiplier
+				bool connection = Riff.ReadBoolean();
+				bool inputCon = Riff.ReadBoolean();
+				if (connection) machine.Outputs.Add(output);
+				if (inputCon) machine.Inputs.Add(input);
+			}
+			machine.EditName = Riff.ReadString(32);
+			
+			Psyfile.Machines[index] = machine;
+		}
+		
+		void ReadInstrument(PsyChunk chunk)
+		{
+			int index = Riff.ReadInt32();
+			if (index < 0 || index >= PsyFile.MaxInstruments) return;
+			
+			PsyInstrument instrument = new PsyInstrument();
+			instrument.Index = index;
+			instrument.Loop = Riff.ReadBoolean();
+			instrument.Lines = Riff.ReadInt32();
+			instrument.NNA = Riff.ReadByte();
+			instrument.EnvAttack = Riff.ReadInt32();
+			instrument.EnvDecay = Riff.ReadInt32();
+			instrument.EnvSustain = Riff.ReadInt32();
+			instrument.EnvRelease = Riff.ReadInt32();
+			instrument.FilterEnvAttack = Riff.ReadInt32();
+			instrument.FilterEnvDecay = Riff.ReadInt32();
+			instrument.FilterEnvSustain = Riff.ReadInt32();
+			instrument.FilterEnvRelease = Riff.ReadInt32();
+			instrument.FilterCutoff = Riff.ReadInt32();
+			instrument.FilterResonance = Riff.ReadInt32();
+			instrument.FilterAmount = Riff.ReadInt32();
+			instrument.FilterType = Riff.ReadInt32();
+			instrument.Panning = Riff.ReadInt32();
+			instrument.RandomPan = Riff.ReadBoolean();
+			instrument.RandomCutoff = Riff.ReadBoolean();
+			instrument.RandomResonance = Riff.ReadBoolean();
+			instrument.Name = Riff.ReadString(32);
+			
+			int numWaves = Riff.ReadInt32();
+			for (int w = 0; w < numWaves; w++)
+			{
+				instrument.Waves.Add(ReadWave());
+			}
+			
+			if ((chunk.Version & 0xFF) > 0)
+			{
+				instrument.LockInstrument = Riff.ReadInt32();
+				instrument.UseLock = Riff.ReadBoolean();
+			}
+			
+			Psyfile.Instruments[index] = instrument;
+		}
+		
+		// Each wave is a nameless chunk with its own version and size.
+		PsyWave ReadWave()
+		{
+			Riff.ReadInt32(); // version
+			int size = (int)Riff.ReadUInt32();
+			long begins = Riff.Position;
+			
+			PsyWave wave = new PsyWave();
+			wave.Index = (int)Riff.ReadUInt32();
+			wave.Length = (int)Riff.ReadUInt32();
+			wave.Volume = (ushort)Riff.ReadInt16();
+			wave.LoopStart = (int)Riff.ReadUInt32();
+			wave.LoopEnd = (int)Riff.ReadUInt32();
+			wave.Tune = Riff.ReadInt32();
+			wave.Finetune = Riff.ReadInt32();
+			wave.Loop = Riff.ReadBoolean();
+			wave.Stereo = Riff.ReadBoolean();
+			wave.Name = Riff.ReadString(32);
+			
+			int leftSize = (int)Riff.ReadUInt32();
+			if (!Riff.CanSeek)
+			{
+				// Nothing can be left in a file that is only read forward.
+				wave.PackedLeft = Riff.ReadBytes(leftSize);
+				if (wave.Stereo) wave.PackedRight = Riff.ReadBytes((int)Riff.ReadUInt32());
+				Riff.Position = begins + size;
+				return wave;
+			}
+			
+			long leftOffset = Riff.Position;
+			Riff.Skip(leftSize);
+			int rightSize = 0;
+			long rightOffset = 0;
+			if (wave.Stereo)
+			{
+				rightSize = (int)Riff.ReadUInt32();
+				rightOffset = Riff.Position;
+			}
+			
+			wave.SetSource(Riff, leftOffset, leftSize, rightOffset, rightSize);
+			if (!Options.LazyWaves) wave.Load();
+			
+			Riff.Position = begins + size;
+			return wave;
+		}
 
 		string ReadPsyVersion()
 		{
 			try
 			{
-				char[] chars = new char[8];
-				Reader.Read(chars, 0, 8);
-				return new string(chars);
+				return Riff.ReadId(8);
 			}
 			catch (Exception ex)
 			{
@@ -88,7 +579,7 @@ namespace PsyFile
 		{
 			try
 			{
-				return (int)Reader.ReadUInt32();
+				return (int)Riff.ReadUInt32();
 			}
 			catch (Exception ex)
 			{
@@ -100,7 +591,7 @@ namespace PsyFile
 		{
 			try
 			{
-				return (int)Reader.ReadUInt32();
+				return (int)Riff.ReadUInt32();
 			}
 			catch (Exception ex)
 			{
@@ -112,7 +603,7 @@ namespace PsyFile
 		{
 			try
 			{
-				return Reader.ReadInt32();
+				return Riff.ReadInt32();
 			}
 			catch (Exception ex)
 			{
@@ -122,55 +613,39 @@ namespace PsyFile
 
 		string ReadTitle()
 		{
-			try
-			{
-				char[] titleChars = new char[128];
-				for (int i = 0; i < 128 && Reader.PeekChar() != 0; i++)
-				{
-					titleChars[i] = Reader.ReadChar();
-				}
-				Reader.ReadChar(); // To get pass the null terminator.
-				return new string(titleChars);
-			}
-			catch (Exception ex)
-			{
-				throw ex;
-			}
+			return Riff.ReadString(128);
 		}
 		
 		string ReadArtist()
 		{
-			try
-			{
-				char[] artistChars = new char[64];
-				for (int i = 0; i < 64 && Reader.PeekChar() != 0; i++)
-				{
-					artistChars[i] = Reader.ReadChar();
-				}
-				Reader.ReadChar();
-				return new string(artistChars);
-			}
-			catch (Exception ex)
-			{
-				throw ex;
-			}
+			return Riff.ReadString(64);
 		}
 		
 		string ReadComments()
 		{
-			try
+			return Riff.ReadString(65535);
+		}
+		
+		// A mapped file unmaps its pages, so no prefetch may be reading them then.
+		public void Dispose()
+		{
+			if (prefetches.Count > 0)
 			{
-				char[] commentsChars = new char[65536];
-				for (int i = 0; i < 65536 && Reader.PeekChar() != 0; i++)
+				prefetchCancel.Cancel();
+				try
+				{
+					Task.WaitAll(prefetches.ToArray());
+				}
+				catch (AggregateException)
 				{
-					commentsChars[i] = Reader.ReadChar();
+					// Left for whoever uses the pattern or wave.
 				}
-				Reader.ReadChar(); // To get past the null terminator.
-				return new string(commentsChars);
+				prefetches.Clear();
 			}
-			catch (Exception ex)
+			if (Riff != null)
 			{
-				throw ex;
+				Riff.Dispose();
+				Riff = null;
 			}
 		}
 	}
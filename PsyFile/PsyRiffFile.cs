@@ -0,0 +1,77 @@
+using System;
+using System.IO;
+
+namespace PsyFile
+{
+	// Read access to the bytes of a .psy file, like psycle's RiffFile.
+	// All values are little endian.
+	public abstract class PsyRiffFile : IDisposable
+	{
+		public abstract long Position { get; set; }
+		public abstract long Length { get; }
+		
+		// False for streams that can only be read forward. Length is then unknown and
+		// Position can only move back a little.
+		public virtual bool CanSeek
+		{
+			get { return true; }
+		}
+		
+		// Whether count more bytes can be read from Position.
+		public virtual bool IsAvailable(long count)
+		{
+			return Position + count <= Length;
+		}
+		
+		public abstract byte ReadByte();
+		public abstract short ReadInt16();
+		public abstract int ReadInt32();
+		public abstract byte[] ReadBytes(int count);
+		
+		// Reads a fixed length id such as "PSY3SONG" or "PATD".
+		public abstract string ReadId(int length);
+		
+		// Reads up to and including the null terminator, truncating to maxLength characters.
+		public abstract string ReadString(int maxLength);
+		
+		// Reads count bytes found at offset. Does not move Position, and can be
+		// called from several threads at once.
+		public abstract byte[] ReadBytesAt(long offset, int count);
+		
+		// Decompresses size bytes of z77 data found at offset. Does not move Position,
+		// and can be called from several threads at once.
+		public abstract byte[] DecompressZ77(long offset, int size);
+		
+		// Up to count bytes from Position, fewer at the end of the file. Does not
+		// move Position.
+		public virtual byte[] Peek(int count)
+		{
+			return ReadBytesAt(Position, (int)Math.Max(0, Math.Min(count, Length - Position)));
+		}
+		
+		public uint ReadUInt32()
+		{
+			return (uint)ReadInt32();
+		}
+		
+		public bool ReadBoolean()
+		{
+			return ReadByte() != 0;
+		}
+		
+		public void Skip(long count)
+		{
+			Position += count;
+		}
+		
+		public void Dispose()
+		{
+			Dispose(true);
+			GC.SuppressFinalize(this);
+		}
+		
+		protected virtual void Dispose(bool disposing)
+		{
+		}
+	}
+}
@@ -0,0 +1,141 @@
+using System;
+
+namespace PsyFile
+{
+	// The cells of a mostly blank pattern that are not blank, in line order:
+	// their index (line * tracks + track) and their five bytes. Memory and scans
+	// cost as much as the events, not as the whole pattern.
+	public class PsySparseCells
+	{
+		int[] cells;
+		byte[] events;
+		int count;
+		
+		// Size of the dense cells, in bytes.
+		public PsySparseCells (int size)
+		{
+			if (size < 0 || size % PsyFile.EventSize != 0) throw new ArgumentOutOfRangeException("size");
+			
+			Size = size;
+			cells = new int[4];
+			events = new byte[4 * PsyFile.EventSize];
+		}
+		
+		public int Size { get; private set; }
+		
+		public int Count
+		{
+			get { return count; }
+		}
+		
+		public static PsySparseCells FromDense(byte[] data)
+		{
+			if (data == null) throw new ArgumentNullException("data");
+			
+			PsySparseCells sparse = new PsySparseCells(data.Length - data.Length % PsyFile.EventSize);
+			for (int s = 0; ; s += PsyFile.EventSize)
+			{
+				int skip = PsyCellScan.FirstUsed(data, s, sparse.Size - s);
+				if (skip < 0) break;
+				s += skip * PsyFile.EventSize;
+				sparse.Append(s / PsyFile.EventSize, data, s);
+			}
+			return sparse;
+		}
+		
+		static bool IsBlank(byte[] data, int s)
+		{
+			return data[s] == PsyPattern.EmptyNote && data[s + 1] == PsyPattern.EmptyInst && data[s + 2] == PsyPattern.EmptyMach
+				&& data[s + 3] == 0 && data[s + 4] == 0;
+		}
+		
+		// Cell indexes and events, valid up to Count, for codecs that read them in bulk.
+		internal int[] Cells
+		{
+			get { return cells; }
+		}
+		
+		internal byte[] Events
+		{
+			get { return events; }
+		}
+		
+		// Index of the i-th cell that is not blank.
+		public int GetCell(int i)
+		{
+			if (i < 0 || i >= count) throw new ArgumentOutOfRangeException("i");
+			return cells[i];
+		}
+		
+		// One of the five bytes of the i-th cell that is not blank.
+		public byte GetField(int i, int field)
+		{
+			if (i < 0 || i >= count) throw new ArgumentOutOfRangeException("i");
+			if (field < 0 || field >= PsyFile.EventSize) throw new ArgumentOutOfRangeException("field");
+			return events[i * PsyFile.EventSize + field];
+		}
+		
+		public byte[] ToDense()
+		{
+			byte[] data = new byte[Size];
+			PsyPattern.FillBlank(data, 0, data.Length);
+			for (int i = 0; i < count; i++)
+			{
+				Buffer.BlockCopy(events, i * PsyFile.EventSize, data, cells[i] * PsyFile.EventSize, PsyFile.EventSize);
+			}
+			return data;
+		}
+		
+		// Setting a blank event removes the cell.
+		public void Set(int cell, byte note, byte inst, byte mach, byte cmd, byte parameter)
+		{
+			if (cell < 0 || cell >= Size / PsyFile.EventSize) throw new ArgumentOutOfRangeException("cell");
+			
+			byte[] e = { note, inst, mach, cmd, parameter };
+			int i = Array.BinarySearch(cells, 0, count, cell);
+			if (IsBlank(e, 0))
+			{
+				if (i < 0) return;
+				Array.Copy(cells, i + 1, cells, i, count - i - 1);
+				Buffer.BlockCopy(events, (i + 1) * PsyFile.EventSize, events, i * PsyFile.EventSize, (count - i - 1) * PsyFile.EventSize);
+				count--;
+				return;
+			}
+			if (i < 0)
+			{
+				i = ~i;
+				Grow();
+				Array.Copy(cells, i, cells, i + 1, count - i);
+				Buffer.BlockCopy(events, i * PsyFile.EventSize, events, (i + 1) * PsyFile.EventSize, (count - i) * PsyFile.EventSize);
+				cells[i] = cell;
+				count++;
+			}
+			Buffer.BlockCopy(e, 0, events, i * PsyFile.EventSize, PsyFile.EventSize);
+		}
+		
+		// Cells have to come in line order.
+		void Append(int cell, byte[] data, int offset)
+		{
+			Grow();
+			cells[count] = cell;
+			Buffer.BlockCopy(data, offset, events, count * PsyFile.EventSize, PsyFile.EventSize);
+			count++;
+		}
+		
+		void Grow()
+		{
+			if (count < cells.Length) return;
+			
+			Array.Resize(ref cells, cells.Length * 2);
+			Array.Resize(ref events, events.Length * 2);
+		}
+		
+		public PsySparseCells Clone()
+		{
+			PsySparseCells copy = (PsySparseCells)MemberwiseClone();
+			copy.cells = (int[])cells.Clone();
+			copy.events = (byte[])events.Clone();
+			return copy;
+		}
+	}
+}
@@ -0,0 +1,92 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+
+namespace PsyFile
+{
+	public class PsyStreamFile : PsyRiffFile
+	{
+		protected Stream Stream;
+		protected BinaryReader Reader;
+		readonly object sync = new object();
+		
+		public PsyStreamFile(Stream stream)
+		{
+			if (stream == null) throw new ArgumentNullException("stream");
+			
+			this.Stream = stream;
+			this.Reader = new BinaryReader(stream);
+		}
+		
+		public override long Position
+		{
+			get { return Stream.Position; }
+			set { Stream.Position = value; }
+		}
+		
+		public override long Length
+		{
+			get { return Stream.Length; }
+		}
+		
+		public override byte ReadByte()
+		{
+			return Reader.ReadByte();
+		}
+		
+		public override short ReadInt16()
+		{
+			return Reader.ReadInt16();
+		}
+		
+		public override int ReadInt32()
+		{
+			return Reader.ReadInt32();
+		}
+		
+		public override byte[] ReadBytes(int count)
+		{
+			byte[] bytes = Reader.ReadBytes(count);
+			if (bytes.Length < count) throw new EndOfStreamException();
+			return bytes;
+		}
+		
+		public override string ReadId(int length)
+		{
+			return PsyFile.StringEncoding.GetString(ReadBytes(length));
+		}
+		
+		public override string ReadString(int maxLength)
+		{
+			List<byte> bytes = new List<byte>();
+			int b;
+			while ((b = Stream.ReadByte()) > 0)
+			{
+				if (bytes.Count < maxLength) bytes.Add((byte)b);
+			}
+			return PsyFile.StringEncoding.GetString(bytes.ToArray());
+		}
+		
+		public override byte[] ReadBytesAt(long offset, int count)
+		{
+			lock (sync)
+			{
+				long position = Stream.Position;
+				Stream.Position = offset;
+				byte[] bytes = ReadBytes(count);
+				Stream.Position = position;
+				return bytes;
+			}
+		}
+		
+		public override byte[] DecompressZ77(long offset, int size)
+		{
+			return BeerZ77.Decompress(ReadBytesAt(offset, size));
+		}
+		
+		protected override void Dispose(bool disposing)
+		{
+			if (disposing) Reader.Close();
+		}
+	}
+}
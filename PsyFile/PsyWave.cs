@@ -0,0 +1,133 @@
+using System;
+
+namespace PsyFile
+{
+	// One wave of a sampler instrument. The wave data stays delta packed, as
+	// found in the INSD chunk.
+	public class PsyWave
+	{
+		public int Index { get; set; }
+		public int Length { get; set; }
+		public int Volume { get; set; }
+		public int LoopStart { get; set; }
+		public int LoopEnd { get; set; }
+		public int Tune { get; set; }
+		public int Finetune { get; set; }
+		public bool Loop { get; set; }
+		public bool Stereo { get; set; }
+		public string Name { get; set; }
+		
+		byte[] packedLeft;
+		byte[] packedRight;
+		PsyRiffFile riff;
+		long leftOffset;
+		int leftSize;
+		long rightOffset;
+		int rightSize;
+		readonly object sync = new object();
+		
+		public PsyWave ()
+		{
+		}
+		
+		public byte[] PackedLeft
+		{
+			get
+			{
+				Load();
+				return packedLeft;
+			}
+			set
+			{
+				Load();
+				packedLeft = value;
+			}
+		}
+		
+		// Null for mono waves.
+		public byte[] PackedRight
+		{
+			get
+			{
+				Load();
+				return packedRight;
+			}
+			set
+			{
+				Load();
+				packedRight = value;
+			}
+		}
+		
+		public bool IsLoaded
+		{
+			get
+			{
+				lock (sync)
+				{
+					return riff == null;
+				}
+			}
+		}
+		
+		// Leaves the packed data in the file, to be read when it is first asked for.
+		// The reader has to stay open until then.
+		public void SetSource(PsyRiffFile riff, long leftOffset, int leftSize, long rightOffset, int rightSize)
+		{
+			lock (sync)
+			{
+				this.riff = riff;
+				this.leftOffset = leftOffset;
+				this.leftSize = leftSize;
+				this.rightOffset = rightOffset;
+				this.rightSize = rightSize;
+			}
+		}
+		
+		public void Load()
+		{
+			lock (sync)
+			{
+				if (riff == null) return;
+				
+				packedLeft = riff.ReadBytesAt(leftOffset, leftSize);
+				if (Stereo) packedRight = riff.ReadBytesAt(rightOffset, rightSize);
+				riff = null;
+			}
+		}
+		
+		// A copy that shares the packed data. The arrays are only ever replaced,
+		// never written into. Data still left in the file is read from the same
+		// reader, which has to stay open until it is.
+		public PsyWave Snapshot()
+		{
+			PsyWave copy = new PsyWave();
+			copy.Index = Index;
+			copy.Length = Length;
+			copy.Volume = Volume;
+			copy.LoopStart = LoopStart;
+			copy.LoopEnd = LoopEnd;
+			copy.Tune = Tune;
+			copy.Finetune = Finetune;
+			copy.Loop = Loop;
+			copy.Stereo = Stereo;
+			copy.Name = Name;
+			lock (sync)
+			{
+				copy.packedLeft = packedLeft;
+				copy.packedRight = packedRight;
+				copy.riff = riff;
+				copy.leftOffset = leftOffset;
+				copy.leftSize = leftSize;
+				copy.rightOffset = rightOffset;
+				copy.rightSize = rightSize;
+			}
+			return copy;
+		}
+		
+		public override string ToString ()
+		{
+			return string.Format ("[PsyWave: Index={0}, Length={1}, Stereo={2}, Name={3}]", Index, Length, Stereo, Name);
+		}
+	}
+}
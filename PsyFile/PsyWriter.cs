@@ -20,11 +20,23 @@ PsyVersion: {0}
 Song Name: {1}
 Artist: {2}
 Comments: {3}
+Tracks: {6}
+BPM: {7}
+LPB: {8}
+Sequence Length: {9}
+Patterns: {4}
+Instruments: {5}
 ",
 				PsyFile.PsyVersion,
 				PsyFile.Title,
 				PsyFile.Artist,
-				PsyFile.Comments
+				PsyFile.Comments,
+				PsyFile.PatternCount,
+				PsyFile.InstrumentCount,
+				PsyFile.Tracks,
+				PsyFile.BeatsPerMinute,
+				PsyFile.LinesPerBeat,
+				PsyFile.PlayOrder.Length
 			);
 		}
 	}
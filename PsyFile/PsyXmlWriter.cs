@@ -0,0 +1,96 @@
+using System;
+using System.Globalization;
+using System.IO;
+using System.Xml;
+
+namespace PsyFile
+{
+	// Objects and arrays become elements, array items are named "item".
+	public class PsyXmlWriter : PsyDocumentWriter
+	{
+		protected XmlWriter Writer;
+		
+		public PsyXmlWriter(TextWriter output)
+			: base(output)
+		{
+			XmlWriterSettings settings = new XmlWriterSettings();
+			settings.Indent = true;
+			settings.CloseOutput = false;
+			this.Writer = XmlWriter.Create(output, settings);
+		}
+		
+		public override void BeginDocument()
+		{
+			Writer.WriteStartDocument();
+			Writer.WriteStartElement("song");
+		}
+		
+		public override void EndDocument()
+		{
+			Writer.WriteEndElement();
+			Writer.WriteEndDocument();
+			Writer.Flush();
+			Output.WriteLine();
+			Output.Flush();
+		}
+		
+		public override void BeginObject(string name)
+		{
+			Writer.WriteStartElement(name ?? "item");
+		}
+		
+		public override void EndObject()
+		{
+			Writer.WriteEndElement();
+		}
+		
+		public override void BeginArray(string name)
+		{
+			Writer.WriteStartElement(name ?? "item");
+		}
+		
+		public override void EndArray()
+		{
+			Writer.WriteEndElement();
+		}
+		
+		public override void WriteValue(string name, string value)
+		{
+			Writer.WriteStartElement(name ?? "item");
+			// Control characters other than tab and newlines are not allowed in XML 1.0.
+			if (value != null) Writer.WriteString(RemoveControlCharacters(value));
+			Writer.WriteEndElement();
+		}
+		
+		public override void WriteValue(string name, long value)
+		{
+			WriteValue(name, value.ToString(CultureInfo.InvariantCulture));
+		}
+		
+		public override void WriteValue(string name, double value)
+		{
+			WriteValue(name, value.ToString("R", CultureInfo.InvariantCulture));
+		}
+		
+		public override void WriteValue(string name, bool value)
+		{
+			WriteValue(name, value ? "true" : "false");
+		}
+		
+		static string RemoveControlCharacters(string value)
+		{
+			char[] chars = value.ToCharArray();
+			for (int i = 0; i < chars.Length; i++)
+			{
+				if (chars[i] < ' ' && chars[i] != '\t' && chars[i] != '\n' && chars[i] != '\r') chars[i] = ' ';
+			}
+			return new string(chars);
+		}
+		
+		protected override void Dispose(bool disposing)
+		{
+			if (disposing) Writer.Close();
+			base.Dispose(disposing);
+		}
+	}
+}
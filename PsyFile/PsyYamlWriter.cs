@@ -0,0 +1,173 @@
+using System;
+using System.Globalization;
+using System.IO;
+using System.Text;
+
+namespace PsyFile
+{
+	// Block style YAML. Strings are always double quoted.
+	public class PsyYamlWriter : PsyDocumentWriter
+	{
+		class Frame
+		{
+			public Frame Parent;
+			public string Name;
+			public bool IsArray;
+			public int Indent;			// Column of the members.
+			public bool Opened;			// The line introducing it has been written.
+			public bool DashPending;	// Object inside an array, its first member starts with "- ".
+		}
+		
+		Frame current;
+		
+		public PsyYamlWriter(TextWriter output)
+			: base(output)
+		{
+		}
+		
+		public override void BeginDocument()
+		{
+			Output.WriteLine("---");
+			current = new Frame();
+			current.Opened = true;
+		}
+		
+		public override void EndDocument()
+		{
+			Output.Flush();
+		}
+		
+		public override void BeginObject(string name)
+		{
+			Push(name, false);
+		}
+		
+		public override void EndObject()
+		{
+			Pop();
+		}
+		
+		public override void BeginArray(string name)
+		{
+			Push(name, true);
+		}
+		
+		public override void EndArray()
+		{
+			Pop();
+		}
+		
+		public override void WriteValue(string name, string value)
+		{
+			WriteScalar(name, value == null ? "null" : Quote(value));
+		}
+		
+		public override void WriteValue(string name, long value)
+		{
+			WriteScalar(name, value.ToString(CultureInfo.InvariantCulture));
+		}
+		
+		public override void WriteValue(string name, double value)
+		{
+			WriteScalar(name, value.ToString("R", CultureInfo.InvariantCulture));
+		}
+		
+		public override void WriteValue(string name, bool value)
+		{
+			WriteScalar(name, value ? "true" : "false");
+		}
+		
+		void Push(string name, bool isArray)
+		{
+			Frame frame = new Frame();
+			frame.Parent = current;
+			frame.Name = name;
+			frame.IsArray = isArray;
+			frame.Indent = current.Indent + 2;
+			current = frame;
+		}
+		
+		// Nothing is written for an object or array until its first member, so that
+		// empty ones can still be written as {} or [].
+		void Pop()
+		{
+			Frame frame = current;
+			current = frame.Parent;
+			if (!frame.Opened)
+			{
+				WriteScalar(frame.Name, frame.IsArray ? "[]" : "{}");
+			}
+		}
+		
+		void WriteScalar(string name, string text)
+		{
+			WriteLine(current, current.IsArray ? text : name + ": " + text);
+		}
+		
+		void Open(Frame frame)
+		{
+			if (frame.Opened) return;
+			
+			frame.Opened = true;
+			if (frame.Parent.IsArray && !frame.IsArray)
+			{
+				Open(frame.Parent);
+				frame.DashPending = true;
+			}
+			else
+			{
+				WriteLine(frame.Parent, frame.Parent.IsArray ? "" : frame.Name + ":");
+			}
+		}
+		
+		void WriteLine(Frame frame, string content)
+		{
+			Open(frame);
+			if (frame.IsArray)
+			{
+				Output.Write(new string(' ', frame.Indent));
+				Output.Write("- ");
+			}
+			else if (frame.DashPending)
+			{
+				Output.Write(new string(' ', frame.Indent - 2));
+				Output.Write("- ");
+				frame.DashPending = false;
+			}
+			else
+			{
+				Output.Write(new string(' ', frame.Indent));
+			}
+			Output.WriteLine(content);
+		}
+		
+		static string Quote(string value)
+		{
+			StringBuilder builder = new StringBuilder(value.Length + 2);
+			builder.Append('"');
+			foreach (char c in value)
+			{
+				switch (c)
+				{
+				case '"': builder.Append("\\\""); break;
+				case '\\': builder.Append("\\\\"); break;
+				case '\n': builder.Append("\\n"); break;
+				case '\r': builder.Append("\\r"); break;
+				case '\t': builder.Append("\\t"); break;
+				default:
+					if (c < ' ')
+					{
+						builder.AppendFormat("\\x{0:x2}", (int)c);
+					}
+					else
+					{
+						builder.Append(c);
+					}
+					break;
+				}
+			}
+			builder.Append('"');
+			return builder.ToString();
+		}
+	}
+}